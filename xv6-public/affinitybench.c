@@ -0,0 +1,88 @@
+// Run more cache-sensitive workers than there are CPUs, each
+// making repeated passes over its own 256KB array, first free
+// to move between CPUs and then pinned one CPU each with
+// sched_setaffinity().  Pinned workers should keep their
+// caches and TLBs warm and get more passes done.
+// Run with make CPUS=2 or more.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define ARRAYSIZE (256*1024)
+#define DURATION  300    // ticks each round runs for
+
+// Make passes over a 256KB array for DURATION ticks and
+// report how many on fd.
+static void
+worker(int fd, int end)
+{
+  int *a, i, n, sum;
+
+  if((a = malloc(ARRAYSIZE)) == 0){
+    printf(1, "affinitybench: malloc failed\n");
+    exit();
+  }
+  memset(a, 0, ARRAYSIZE);
+  sum = 0;
+  for(n = 0; uptime() < end; n++){
+    for(i = 0; i < ARRAYSIZE/sizeof(int); i++){
+      sum += a[i];
+      a[i] = sum;
+    }
+  }
+  write(fd, &n, sizeof(n));
+  exit();
+}
+
+static void
+run(int nworkers, int pin, int ncpu)
+{
+  int fds[2], i, n, total, end;
+
+  if(pipe(fds) < 0){
+    printf(1, "affinitybench: pipe failed\n");
+    exit();
+  }
+  end = uptime() + DURATION;
+  for(i = 0; i < nworkers; i++){
+    if(fork() == 0){
+      close(fds[0]);
+      if(pin && sched_setaffinity(0, 1 << (i % ncpu)) < 0){
+        printf(1, "affinitybench: sched_setaffinity failed\n");
+        exit();
+      }
+      worker(fds[1], end);
+    }
+  }
+  close(fds[1]);
+  total = 0;
+  printf(1, "%s:", pin ? "pinned" : "unpinned");
+  for(i = 0; i < nworkers; i++){
+    if(read(fds[0], &n, sizeof(n)) != sizeof(n)){
+      printf(1, "\naffinitybench: short read\n");
+      exit();
+    }
+    printf(1, " %d", n);
+    total += n;
+  }
+  printf(1, " passes, %d in all\n", total);
+  close(fds[0]);
+  for(i = 0; i < nworkers; i++)
+    wait();
+}
+
+int
+main(int argc, char *argv[])
+{
+  int ncpu;
+
+  printf(1, "affinitybench starting\n");
+  ncpu = ncpus();
+  if(ncpu < 2)
+    printf(1, "affinitybench: only one CPU; run with make CPUS=2\n");
+  run(ncpu + 1, 0, ncpu);
+  run(ncpu + 1, 1, ncpu);
+  printf(1, "affinitybench ok\n");
+  exit();
+}
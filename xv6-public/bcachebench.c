@@ -0,0 +1,55 @@
+// Run several processes that hammer the same inode and buffer
+// cache entries, so that they contend on the same sleep locks.
+// Run it under lockstat to see how often acquiresleep() slept.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+
+#define NWORKERS 4
+#define ROUNDS   2000
+
+int
+main(int argc, char *argv[])
+{
+  struct stat st;
+  char buf[512];
+  int fd, i, w, t0, t1;
+
+  printf(1, "bcachebench starting\n");
+  if((fd = open("bcfile", O_CREATE | O_RDWR)) < 0){
+    printf(1, "bcachebench: create bcfile failed\n");
+    exit();
+  }
+  memset(buf, 'b', sizeof(buf));
+  write(fd, buf, sizeof(buf));
+  close(fd);
+
+  t0 = uptime();
+  for(w = 0; w < NWORKERS; w++){
+    if(fork() == 0){
+      for(i = 0; i < ROUNDS; i++){
+        if((fd = open("bcfile", O_RDONLY)) < 0){
+          printf(1, "bcachebench: open bcfile failed\n");
+          exit();
+        }
+        if(read(fd, buf, sizeof(buf)) != sizeof(buf) || fstat(fd, &st) < 0){
+          printf(1, "bcachebench: read bcfile failed\n");
+          exit();
+        }
+        close(fd);
+      }
+      exit();
+    }
+  }
+  for(w = 0; w < NWORKERS; w++)
+    wait();
+  t1 = uptime();
+
+  printf(1, "%d workers x %d open/read/fstat/close: %d ticks\n",
+         NWORKERS, ROUNDS, t1 - t0);
+  unlink("bcfile");
+  printf(1, "bcachebench ok\n");
+  exit();
+}
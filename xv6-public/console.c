@@ -248,7 +248,11 @@ consoleread(struct inode *ip, char *dst, int n)
         ilock(ip);
         return -1;
       }
-      sleep(&input.r, &cons.lock);
+      if(sleepuser(&input.r, &cons.lock, dst, n) < 0){
+        release(&cons.lock);
+        ilock(ip);
+        return -1;
+      }
     }
     c = input.buf[input.r++ % INPUT_BUF];
     if(c == C('D')){  // EOF
@@ -0,0 +1,93 @@
+// Time path lookups in a large directory.
+// Creates NFILE names in one directory (hard links to a
+// single inode, so the benchmark fits in the default
+// inode count), then opens every name, and every name
+// that does not exist, ROUNDS times.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+
+#define NFILE  500
+#define ROUNDS 4
+
+char path[32];
+
+// Build "dcdir/<c><n>" in path.
+char*
+mkpath(char c, int n)
+{
+  char *p;
+  int i, d;
+
+  strcpy(path, "dcdir/");
+  p = path + strlen(path);
+  *p++ = c;
+  for(d = 1; d * 10 <= n; d *= 10)
+    ;
+  for(i = d; i > 0; i /= 10)
+    *p++ = '0' + (n / i) % 10;
+  *p = 0;
+  return path;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int fd, i, r, t0, t1;
+
+  printf(1, "dcachebench starting\n");
+
+  if(mkdir("dcdir") < 0){
+    printf(1, "dcachebench: mkdir dcdir failed\n");
+    exit();
+  }
+  if((fd = open(mkpath('f', 0), O_CREATE | O_RDWR)) < 0){
+    printf(1, "dcachebench: create failed\n");
+    exit();
+  }
+  close(fd);
+
+  t0 = uptime();
+  for(i = 1; i < NFILE; i++){
+    if(link("dcdir/f0", mkpath('f', i)) < 0){
+      printf(1, "dcachebench: link %s failed\n", path);
+      exit();
+    }
+  }
+  t1 = uptime();
+  printf(1, "create %d names: %d ticks\n", NFILE, t1 - t0);
+
+  t0 = uptime();
+  for(r = 0; r < ROUNDS; r++){
+    for(i = 0; i < NFILE; i++){
+      if((fd = open(mkpath('f', i), O_RDONLY)) < 0){
+        printf(1, "dcachebench: open %s failed\n", path);
+        exit();
+      }
+      close(fd);
+    }
+  }
+  t1 = uptime();
+  printf(1, "open %d names x %d: %d ticks\n", NFILE, ROUNDS, t1 - t0);
+
+  t0 = uptime();
+  for(r = 0; r < ROUNDS; r++){
+    for(i = 0; i < NFILE; i++){
+      if((fd = open(mkpath('x', i), O_RDONLY)) >= 0){
+        printf(1, "dcachebench: open %s succeeded\n", path);
+        exit();
+      }
+    }
+  }
+  t1 = uptime();
+  printf(1, "open %d missing names x %d: %d ticks\n", NFILE, ROUNDS, t1 - t0);
+
+  for(i = 0; i < NFILE; i++)
+    unlink(mkpath('f', i));
+  unlink("dcdir");
+
+  printf(1, "dcachebench ok\n");
+  exit();
+}
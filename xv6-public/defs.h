@@ -1,14 +1,26 @@
 struct buf;
 struct context;
+struct cpu;
+struct fdtable;
 struct file;
+struct fsstat;
 struct inode;
+struct page;
 struct pipe;
+struct iovec;
+struct slab;
+struct slabstat;
+struct lockstat;
+struct pstat;
+struct rwlock;
+struct lockclass;
 struct proc;
 struct rtcdate;
 struct spinlock;
 struct sleeplock;
 struct stat;
 struct superblock;
+struct vmspace;
 
 // bio.c
 void binit(void);
@@ -33,13 +45,30 @@ void fileinit(void);
 int fileread(struct file *, char *, int n);
 int filestat(struct file *, struct stat *);
 int filewrite(struct file *, char *, int n);
+int filewriteback(struct file *, char *, uint, int);
+int filesplice(struct file *, struct file *, int);
+int filereadv(struct file *, struct iovec *, int);
+int filewritev(struct file *, struct iovec *, int);
+struct fdtable *fdtablealloc(void);
+struct fdtable *fdtablecopy(struct fdtable *);
+struct fdtable *fdtabledup(struct fdtable *);
+void fdtableput(struct fdtable *);
+struct file *fdget(struct fdtable *, int);
+int fdalloc(struct fdtable *, struct file *);
+struct file *fdremove(struct fdtable *, int);
+struct inode *fdcwd(struct fdtable *);
+struct inode *fdchdir(struct fdtable *, struct inode *);
 
 // fs.c
 void readsb(int dev, struct superblock *sb);
 int dirlink(struct inode *, char *, uint);
+void dirunlink(struct inode *, char *, uint);
 struct inode *dirlookup(struct inode *, char *, uint *);
+void getfsstat(struct fsstat *);
+struct page *igetpage(struct inode *, uint);
 struct inode *ialloc(uint, short);
 struct inode *idup(struct inode *);
+void icacheinit(void);
 void iinit(int dev);
 void ilock(struct inode *);
 void iput(struct inode *);
@@ -63,9 +92,19 @@ void ioapicenable(int irq, int cpu);
 extern uchar ioapicid;
 void ioapicinit(void);
 
+// ipi.c
+void ipiinit(void);
+void ipiresched(struct cpu *);
+int ipicall(int, void (*)(void *), void *);
+void ipicallall(void (*)(void *), void *);
+void ipipoll(void);
+void tlbshootdown(struct vmspace *);
+int ipiping(int, int);
+
 // kalloc.c
 char *kalloc(void);
 void kfree(char *);
+int kfreepages(void);
 void kinit1(void *, void *);
 void kinit2(void *, void *);
 
@@ -78,7 +117,10 @@ int lapicid(void);
 extern volatile uint *lapic;
 void lapiceoi(void);
 void lapicinit(void);
+void lapicipi(int, int);
 void lapicstartap(uchar, uint);
+extern uint tickcycles;
+uint tsc2us(uint64);
 void microdelay(int);
 
 // log.c
@@ -95,11 +137,31 @@ void mpinit(void);
 void picenable(int);
 void picinit(void);
 
+// mmap.c
+int mmap(int, int, int, struct file *, int);
+int munmap(uint, int);
+void munmapall(struct vmspace *);
+int mmapfault(uint);
+int mmapcheck(uint, int);
+uint mmapend(uint);
+int mmapfork(struct vmspace *, struct vmspace *);
+uint mmaplow(struct vmspace *);
+
+// pcache.c
+void pcacheinit(void);
+struct page *pget(uint, uint, uint, int);
+void pput(struct page *);
+void pinval(uint, uint, uint, uint);
+void pcachestat(uint *, uint *);
+
 // pipe.c
+void pipeinit(void);
 int pipealloc(struct file **, struct file **);
 void pipeclose(struct pipe *, int);
 int piperead(struct pipe *, char *, int);
 int pipewrite(struct pipe *, char *, int);
+int pipepeek(struct pipe *, char **, int, int);
+void pipeconsume(struct pipe *, int);
 
 //PAGEBREAK: 16
 // proc.c
@@ -107,6 +169,17 @@ int cpuid(void);
 void exit(void);
 int fork(void);
 int growproc(int);
+struct vmspace *vmspacealloc(pde_t *, uint);
+int vmspaceleave(struct vmspace *);
+void vmspaceput(struct vmspace *);
+void vmuse(struct proc *);
+void vmunuse(struct proc *);
+void vmshrink(struct vmspace *);
+void vmshrinkdone(struct vmspace *);
+int sleepuser(void *, struct spinlock *, char *, int);
+int clone(void (*)(void *), void *, void *);
+int join(int);
+int killthreads(void);
 int kill(int);
 struct cpu *mycpu(void);
 struct proc *myproc();
@@ -120,14 +193,39 @@ void userinit(void);
 int wait(void);
 void wakeup(void *);
 void yield(void);
+int needresched(void);
+int cpuPreference(struct proc *);
+int setaffinity(int, uint);
+int getaffinity(int);
+int setnice(int, int, int);
+int setsched(int, int, int);
 int getpinfo(int);
+int getpstat(int, struct pstat *);
 
 // swtch.S
 void swtch(struct context **, struct context *);
 
+// rwlock.c
+void initrwlock(struct rwlock *, char *);
+void acquireread(struct rwlock *);
+void releaseread(struct rwlock *);
+void acquirewrite(struct rwlock *);
+void releasewrite(struct rwlock *);
+
+// slab.c
+void slabinit(struct slab *, char *, uint);
+void *slaballoc(struct slab *);
+void slabfree(struct slab *, void *);
+int slabstat(int, struct slabstat *);
+
 // spinlock.c
 void acquire(struct spinlock *);
 void getcallerpcs(void *, uint *);
+int lockstat(int, struct lockstat *);
+void lockstatreset(void);
+struct lockclass *lockclassfor(char *, int);
+void lockcount(struct lockclass *, uint64, int);
+void lockhold(struct lockclass *, uint64);
 int holding(struct spinlock *);
 void initlock(struct spinlock *, char *);
 void release(struct spinlock *);
@@ -152,9 +250,10 @@ char *strncpy(char *, const char *, int);
 // syscall.c
 int argint(int, int *);
 int argptr(int, char **, int);
-int argstr(int, char **);
+int checkptr(uint, int);
+int argstr(int, char *, int);
 int fetchint(uint, int *);
-int fetchstr(uint, char **);
+int fetchstr(uint, char *, int);
 void syscall(void);
 
 // timer.c
@@ -186,6 +285,8 @@ void switchuvm(struct proc *);
 void switchkvm(void);
 int copyout(pde_t *, uint, void *, uint);
 void clearpteu(pde_t *pgdir, char *uva);
+pte_t *walkpgdir(pde_t *, const void *, int);
+int mappages(pde_t *, void *, uint, uint, int);
 
 // number of elements in fixed-size array
 #define NELEM(x) (sizeof(x) / sizeof((x)[0]))
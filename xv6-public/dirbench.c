@@ -0,0 +1,77 @@
+// Time creating, stat()ing and removing NFILE files
+// in one directory.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+
+#define NFILE 1000
+
+char path[32];
+
+// Build "dbdir/f<n>" in path.
+char*
+mkpath(int n)
+{
+  char *p;
+  int i, d;
+
+  strcpy(path, "dbdir/f");
+  p = path + strlen(path);
+  for(d = 1; d * 10 <= n; d *= 10)
+    ;
+  for(i = d; i > 0; i /= 10)
+    *p++ = '0' + (n / i) % 10;
+  *p = 0;
+  return path;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int fd, i, t0, t1;
+  struct stat st;
+
+  printf(1, "dirbench starting\n");
+
+  if(mkdir("dbdir") < 0){
+    printf(1, "dirbench: mkdir dbdir failed\n");
+    exit();
+  }
+
+  t0 = uptime();
+  for(i = 0; i < NFILE; i++){
+    if((fd = open(mkpath(i), O_CREATE | O_RDWR)) < 0){
+      printf(1, "dirbench: create %s failed\n", path);
+      exit();
+    }
+    close(fd);
+  }
+  t1 = uptime();
+  printf(1, "create %d files: %d ticks\n", NFILE, t1 - t0);
+
+  t0 = uptime();
+  for(i = 0; i < NFILE; i++){
+    if(stat(mkpath(i), &st) < 0 || st.type != T_FILE){
+      printf(1, "dirbench: stat %s failed\n", path);
+      exit();
+    }
+  }
+  t1 = uptime();
+  printf(1, "stat %d files: %d ticks\n", NFILE, t1 - t0);
+
+  t0 = uptime();
+  for(i = 0; i < NFILE; i++){
+    if(unlink(mkpath(i)) < 0){
+      printf(1, "dirbench: unlink %s failed\n", path);
+      exit();
+    }
+  }
+  t1 = uptime();
+  printf(1, "unlink %d files: %d ticks\n", NFILE, t1 - t0);
+
+  unlink("dbdir");
+  printf(1, "dirbench ok\n");
+  exit();
+}
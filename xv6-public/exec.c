@@ -4,6 +4,9 @@
 #include "mmu.h"
 #include "proc.h"
 #include "defs.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "vmspace.h"
 #include "x86.h"
 #include "elf.h"
 
@@ -16,7 +19,8 @@ exec(char *path, char **argv)
   struct elfhdr elf;
   struct inode *ip;
   struct proghdr ph;
-  pde_t *pgdir, *oldpgdir;
+  pde_t *pgdir;
+  struct vmspace *vm, *oldvm;
   struct proc *curproc = myproc();
 
   begin_op();
@@ -87,6 +91,14 @@ exec(char *path, char **argv)
   if(copyout(pgdir, sp, ustack, (3+argc+1)*4) < 0)
     goto bad;
 
+  // The new program replaces the whole process, so the other
+  // threads go, and with them the last sharers of the old
+  // address space and of the descriptor table.
+  if(killthreads() < 0)
+    goto bad;
+  if((vm = vmspacealloc(pgdir, sz)) == 0)
+    goto bad;
+
   // Save program name for debugging.
   for(last=s=path; *s; s++)
     if(*s == '/')
@@ -94,13 +106,14 @@ exec(char *path, char **argv)
   safestrcpy(curproc->name, last, sizeof(curproc->name));
 
   // Commit to the user image.
-  oldpgdir = curproc->pgdir;
-  curproc->pgdir = pgdir;
-  curproc->sz = sz;
+  oldvm = curproc->vm;
+  if(vmspaceleave(oldvm))
+    munmapall(oldvm);
+  curproc->vm = vm;
   curproc->tf->eip = elf.entry;  // main
   curproc->tf->esp = sp;
   switchuvm(curproc);
-  freevm(oldpgdir);
+  vmspaceput(oldvm);
   return 0;
 
  bad:
@@ -5,21 +5,32 @@
 #include "types.h"
 #include "defs.h"
 #include "param.h"
+#include "mmu.h"
+#include "stat.h"
 #include "fs.h"
 #include "spinlock.h"
 #include "sleeplock.h"
 #include "file.h"
+#include "pcache.h"
+#include "slab.h"
+#include "uio.h"
 
 struct devsw devsw[NDEV];
+// Files are allocated from a slab, so the number of open
+// files is limited only by memory.  ftable.lock protects
+// the reference counts.
 struct {
   struct spinlock lock;
-  struct file file[NFILE];
+  struct slab slab;
+  struct slab fdslab;  // fdtables
 } ftable;
 
 void
 fileinit(void)
 {
   initlock(&ftable.lock, "ftable");
+  slabinit(&ftable.slab, "file", sizeof(struct file));
+  slabinit(&ftable.fdslab, "fdtable", sizeof(struct fdtable));
 }
 
 // Allocate a file structure.
@@ -28,16 +39,11 @@ filealloc(void)
 {
   struct file *f;
 
-  acquire(&ftable.lock);
-  for(f = ftable.file; f < ftable.file + NFILE; f++){
-    if(f->ref == 0){
-      f->ref = 1;
-      release(&ftable.lock);
-      return f;
-    }
-  }
-  release(&ftable.lock);
-  return 0;
+  if((f = slaballoc(&ftable.slab)) == 0)
+    return 0;
+  memset(f, 0, sizeof(*f));
+  f->ref = 1;
+  return f;
 }
 
 // Increment ref count for file f.
@@ -69,6 +75,7 @@ fileclose(struct file *f)
   f->ref = 0;
   f->type = FD_NONE;
   release(&ftable.lock);
+  slabfree(&ftable.slab, f);
 
   if(ff.type == FD_PIPE)
     pipeclose(ff.pipe, ff.writable);
@@ -79,6 +86,154 @@ fileclose(struct file *f)
   }
 }
 
+//PAGEBREAK!
+// Allocate an empty descriptor table.
+struct fdtable*
+fdtablealloc(void)
+{
+  struct fdtable *t;
+
+  if((t = slaballoc(&ftable.fdslab)) == 0)
+    return 0;
+  memset(t, 0, sizeof(*t));
+  initlock(&t->lock, "fdtable");
+  t->ref = 1;
+  return t;
+}
+
+// Allocate a copy of t, for fork(), holding references of
+// its own to t's open files and current directory.
+struct fdtable*
+fdtablecopy(struct fdtable *t)
+{
+  struct fdtable *nt;
+  int fd;
+
+  if((nt = fdtablealloc()) == 0)
+    return 0;
+  acquire(&t->lock);
+  for(fd = 0; fd < NOFILE; fd++)
+    if(t->ofile[fd])
+      nt->ofile[fd] = filedup(t->ofile[fd]);
+  nt->cwd = idup(t->cwd);
+  release(&t->lock);
+  return nt;
+}
+
+// Share t with another process, for clone().
+struct fdtable*
+fdtabledup(struct fdtable *t)
+{
+  acquire(&t->lock);
+  t->ref++;
+  release(&t->lock);
+  return t;
+}
+
+// Drop a process's use of t.  The last one out closes
+// the files and releases the current directory.
+void
+fdtableput(struct fdtable *t)
+{
+  int fd;
+
+  acquire(&t->lock);
+  if(--t->ref > 0){
+    release(&t->lock);
+    return;
+  }
+  release(&t->lock);
+
+  for(fd = 0; fd < NOFILE; fd++)
+    if(t->ofile[fd])
+      fileclose(t->ofile[fd]);
+  if(t->cwd){
+    begin_op();
+    iput(t->cwd);
+    end_op();
+  }
+  slabfree(&ftable.fdslab, t);
+}
+
+// Return the file open as fd in t, with a reference of its
+// own so that another thread closing fd cannot free it
+// while the caller uses it, or 0.  The caller must
+// fileclose() it.
+struct file*
+fdget(struct fdtable *t, int fd)
+{
+  struct file *f;
+
+  if(fd < 0 || fd >= NOFILE)
+    return 0;
+  acquire(&t->lock);
+  if((f = t->ofile[fd]) != 0)
+    filedup(f);
+  release(&t->lock);
+  return f;
+}
+
+// Allocate a file descriptor in t for f.
+// Takes over file reference from caller on success.
+int
+fdalloc(struct fdtable *t, struct file *f)
+{
+  int fd;
+
+  acquire(&t->lock);
+  for(fd = 0; fd < NOFILE; fd++){
+    if(t->ofile[fd] == 0){
+      t->ofile[fd] = f;
+      release(&t->lock);
+      return fd;
+    }
+  }
+  release(&t->lock);
+  return -1;
+}
+
+// Free descriptor fd in t and return the file it held, whose
+// reference passes to the caller, or 0.
+struct file*
+fdremove(struct fdtable *t, int fd)
+{
+  struct file *f;
+
+  if(fd < 0 || fd >= NOFILE)
+    return 0;
+  acquire(&t->lock);
+  f = t->ofile[fd];
+  t->ofile[fd] = 0;
+  release(&t->lock);
+  return f;
+}
+
+// Return t's current directory, with a reference of its own.
+struct inode*
+fdcwd(struct fdtable *t)
+{
+  struct inode *ip;
+
+  acquire(&t->lock);
+  ip = idup(t->cwd);
+  release(&t->lock);
+  return ip;
+}
+
+// Make ip, whose reference passes to t, t's current directory.
+// Returns the old one, for the caller to iput().
+struct inode*
+fdchdir(struct fdtable *t, struct inode *ip)
+{
+  struct inode *old;
+
+  acquire(&t->lock);
+  old = t->cwd;
+  t->cwd = ip;
+  release(&t->lock);
+  return old;
+}
+
 // Get metadata about file f.
 int
 filestat(struct file *f, struct stat *st)
@@ -112,46 +267,256 @@ fileread(struct file *f, char *addr, int n)
   panic("fileread");
 }
 
+// Read into the iovcnt buffers of iov from file f.
+// Stops at the first short read.
+int
+filereadv(struct file *f, struct iovec *iov, int iovcnt)
+{
+  char *run;
+  int i, r, m, tot;
+
+  if(f->readable == 0)
+    return -1;
+  if(f->type == FD_PIPE){
+    // Wait only for the first buffer; take whatever
+    // else is already in the pipe.
+    for(i = 0; i < iovcnt && iov[i].iov_len == 0; i++)
+      ;
+    if(i == iovcnt || (tot = piperead(f->pipe, iov[i].iov_base, iov[i].iov_len)) <= 0)
+      return i == iovcnt ? 0 : tot;
+    m = tot;
+    while(m == iov[i].iov_len){
+      if(++i == iovcnt)
+        break;
+      for(m = 0; m < iov[i].iov_len; m += r){
+        if((r = pipepeek(f->pipe, &run, iov[i].iov_len - m, 0)) <= 0)
+          return tot;
+        memmove((char*)iov[i].iov_base + m, run, r);
+        pipeconsume(f->pipe, r);
+        tot += r;
+      }
+    }
+    return tot;
+  }
+  if(f->type == FD_INODE){
+    tot = 0;
+    ilock(f->ip);
+    for(i = 0; i < iovcnt; i++){
+      if((r = readi(f->ip, iov[i].iov_base, f->off, iov[i].iov_len)) < 0){
+        if(tot == 0)
+          tot = -1;
+        break;
+      }
+      f->off += r;
+      tot += r;
+      if(r < iov[i].iov_len)
+        break;
+    }
+    iunlock(f->ip);
+    return tot;
+  }
+  panic("filereadv");
+}
+
 //PAGEBREAK!
+// Write the iovcnt buffers of iov to inode ip at *off,
+// advancing *off.  iov is in kernel memory, and its lengths
+// add up to no more than an int holds (see argiov()).
+static int
+writeinodev(struct inode *ip, struct iovec *iov, int iovcnt, uint *off)
+{
+  int i, r, n, n1, tot, done, budget;
+
+  // write a few blocks at a time to avoid exceeding
+  // the maximum log transaction size, including
+  // i-node, indirect block, allocation blocks,
+  // and 2 blocks of slop for non-aligned writes.
+  // this really belongs lower down, since writei()
+  // might be writing a device like the console.
+  // The buffers land contiguously in the file, so they
+  // share one transaction up to the same limit.
+  int max = ((MAXOPBLOCKS-1-1-2) / 2) * 512;
+
+  n = 0;
+  for(i = 0; i < iovcnt; i++)
+    n += iov[i].iov_len;
+  tot = 0;
+  i = 0;
+  done = 0;  // bytes of iov[i] already written
+  r = 0;
+  while(tot < n){
+    begin_op();
+    ilock(ip);
+    for(budget = max; budget > 0 && tot < n; ){
+      n1 = iov[i].iov_len - done;
+      if(n1 > budget)
+        n1 = budget;
+      if(n1 > 0){
+        if((r = writei(ip, (char*)iov[i].iov_base + done, *off, n1)) > 0)
+          *off += r;
+        if(r != n1)
+          break;
+        budget -= n1;
+        done += n1;
+        tot += n1;
+      }
+      if(done == iov[i].iov_len){
+        i++;
+        done = 0;
+      }
+    }
+    iunlock(ip);
+    end_op();
+
+    if(r < 0)
+      break;
+    if(budget > 0 && tot < n)
+      panic("short filewrite");
+  }
+  return tot == n ? n : -1;
+}
+
+// Write n bytes from addr to inode ip at *off, advancing *off.
+static int
+writeinode(struct inode *ip, char *addr, uint *off, int n)
+{
+  struct iovec iov;
+
+  iov.iov_base = addr;
+  iov.iov_len = n;
+  return writeinodev(ip, &iov, 1, off);
+}
+
 // Write to file f.
 int
 filewrite(struct file *f, char *addr, int n)
 {
-  int r;
-
   if(f->writable == 0)
     return -1;
   if(f->type == FD_PIPE)
     return pipewrite(f->pipe, addr, n);
-  if(f->type == FD_INODE){
-    // write a few blocks at a time to avoid exceeding
-    // the maximum log transaction size, including
-    // i-node, indirect block, allocation blocks,
-    // and 2 blocks of slop for non-aligned writes.
-    // this really belongs lower down, since writei()
-    // might be writing a device like the console.
-    int max = ((MAXOPBLOCKS-1-1-2) / 2) * 512;
-    int i = 0;
-    while(i < n){
-      int n1 = n - i;
-      if(n1 > max)
-        n1 = max;
-
-      begin_op();
-      ilock(f->ip);
-      if ((r = writei(f->ip, addr + i, f->off, n1)) > 0)
-        f->off += r;
-      iunlock(f->ip);
-      end_op();
-
-      if(r < 0)
+  if(f->type == FD_INODE)
+    return writeinode(f->ip, addr, &f->off, n);
+  panic("filewrite");
+}
+
+// Write the iovcnt buffers of iov to file f.
+int
+filewritev(struct file *f, struct iovec *iov, int iovcnt)
+{
+  int i, tot;
+
+  if(f->writable == 0)
+    return -1;
+  if(f->type == FD_PIPE){
+    for(tot = i = 0; i < iovcnt; i++){
+      if(pipewrite(f->pipe, iov[i].iov_base, iov[i].iov_len) < 0)
+        return -1;
+      tot += iov[i].iov_len;
+    }
+    return tot;
+  }
+  if(f->type == FD_INODE)
+    return writeinodev(f->ip, iov, iovcnt, &f->off);
+  panic("filewritev");
+}
+
+// Write back n bytes of a shared mapping of f, from addr
+// to offset off.  Never extends the file.
+int
+filewriteback(struct file *f, char *addr, uint off, int n)
+{
+  uint size;
+
+  ilock(f->ip);
+  size = f->ip->size;
+  iunlock(f->ip);
+  if(off >= size)
+    return 0;
+  if(off + n > size)
+    n = size - off;
+  return writeinode(f->ip, addr, &off, n);
+}
+
+
+// Move file data from the page cache into pipe p,
+// starting at in->off, without a user-space copy.
+static int
+splicetopipe(struct file *in, struct pipe *p, int n)
+{
+  struct inode *ip = in->ip;
+  struct page *pg;
+  char *bounce;
+  int tot, m, r;
+
+  bounce = 0;
+  for(tot = 0; tot < n; tot += m){
+    ilock(ip);
+    if(ip->type != T_FILE || in->off >= ip->size){
+      iunlock(ip);
+      break;
+    }
+    m = n - tot;
+    if(m > ip->size - in->off)
+      m = ip->size - in->off;
+    if(m > PGSIZE - in->off % PGSIZE)
+      m = PGSIZE - in->off % PGSIZE;
+    if((pg = igetpage(ip, in->off / PGSIZE)) == 0){
+      // Every cached page is in use; copy through a kernel page.
+      if(bounce == 0 && (bounce = kalloc()) == 0){
+        iunlock(ip);
         break;
-      if(r != n1)
-        panic("short filewrite");
-      i += r;
+      }
+      m = readi(ip, bounce, in->off, m);
+    }
+    iunlock(ip);
+    // pipewrite() may sleep; the page reference keeps pg cached.
+    r = pipewrite(p, pg ? pg->data + in->off % PGSIZE : bounce, m);
+    if(pg)
+      pput(pg);
+    if(r < 0){
+      tot = tot ? tot : -1;
+      break;
     }
-    return i == n ? n : -1;
+    in->off += m;
   }
-  panic("filewrite");
+  if(bounce)
+    kfree(bounce);
+  return tot;
+}
+
+// Move data from pipe p straight out of the pipe's ring
+// into out at out->off.  Waits only for the first byte.
+static int
+splicefrompipe(struct pipe *p, struct file *out, int n)
+{
+  char *run;
+  int tot, m;
+
+  for(tot = 0; tot < n; tot += m){
+    if((m = pipepeek(p, &run, n - tot, tot == 0)) <= 0){
+      if(m < 0 && tot == 0)
+        return -1;
+      break;
+    }
+    m = writeinode(out->ip, run, &out->off, m);
+    pipeconsume(p, m < 0 ? 0 : m);
+    if(m < 0)
+      return tot ? tot : -1;
+  }
+  return tot;
 }
 
+// Move up to n bytes from in to out inside the kernel.
+// One of in and out must be a pipe and the other an inode.
+int
+filesplice(struct file *in, struct file *out, int n)
+{
+  if(in->readable == 0 || out->writable == 0 || n < 0)
+    return -1;
+  if(in->type == FD_INODE && out->type == FD_PIPE)
+    return splicetopipe(in, out->pipe, n);
+  if(in->type == FD_PIPE && out->type == FD_INODE)
+    return splicefrompipe(in->pipe, out, n);
+  return -1;
+}
@@ -8,12 +8,23 @@ struct file {
   uint off;
 };
 
+// Open files and current directory.  fork() gives the child
+// a copy; the threads clone() makes share one (see file.c).
+struct fdtable {
+  struct spinlock lock;       // protects everything below
+  int ref;                    // processes using it
+  struct file *ofile[NOFILE]; // Open files
+  struct inode *cwd;          // Current directory
+};
 
 // in-memory copy of an inode
 struct inode {
   uint dev;           // Device number
   uint inum;          // Inode number
   int ref;            // Reference count
+  struct inode *hnext; // icache hash chain
+  struct inode *prev;  // icache LRU list, while ref == 0
+  struct inode *next;
   struct sleeplock lock; // protects everything below here
   int valid;          // inode has been read from disk?
 
@@ -23,6 +34,8 @@ struct inode {
   short nlink;
   uint size;
   uint addrs[NDIRECT+1];
+
+  uint freeoff;       // T_DIR: no free dirent below this offset
 };
 
 // table mapping major device number to
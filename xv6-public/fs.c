@@ -17,12 +17,18 @@
 #include "proc.h"
 #include "spinlock.h"
 #include "sleeplock.h"
+#include "rwlock.h"
 #include "fs.h"
 #include "buf.h"
 #include "file.h"
+#include "fsstat.h"
+#include "pcache.h"
+#include "slab.h"
 
 #define min(a, b) ((a) < (b) ? (a) : (b))
 static void itrunc(struct inode*);
+static void dcinit(void);
+static void dcpurge(uint, uint);
 // there should be one superblock per disk device, but we run with
 // only one device
 struct superblock sb; 
@@ -121,17 +127,21 @@ bfree(int dev, uint b)
 //   the reference and link counts have fallen to zero.
 //
 // * Referencing in cache: an entry in the inode cache
-//   is free if ip->ref is zero. Otherwise ip->ref tracks
-//   the number of in-memory pointers to the entry (open
-//   files and current directories). iget() finds or
+//   is unreferenced if ip->ref is zero. Otherwise ip->ref
+//   tracks the number of in-memory pointers to the entry
+//   (open files and current directories). iget() finds or
 //   creates a cache entry and increments its ref; iput()
-//   decrements ref.
+//   decrements ref. Unreferenced entries stay in the cache,
+//   on an LRU list, until iget() recycles the least recently
+//   used one for a different inode.
 //
 // * Valid: the information (type, size, &c) in an inode
 //   cache entry is only correct when ip->valid is 1.
-//   ilock() reads the inode from
-//   the disk and sets ip->valid, while iput() clears
-//   ip->valid if ip->ref has fallen to zero.
+//   ilock() reads the inode from the disk and sets
+//   ip->valid. An unreferenced entry keeps ip->valid, so
+//   re-opening a recently used inode needs no disk read;
+//   iget() clears it when the entry is recycled, and iput()
+//   clears it when the inode is freed.
 //
 // * Locked: file system code may only examine and modify
 //   the information in an inode and its content if it
@@ -159,31 +169,59 @@ bfree(int dev, uint b)
 // entries. Since ip->ref indicates whether an entry is free,
 // and ip->dev and ip->inum indicate which i-node an entry
 // holds, one must hold icache.lock while using any of those fields.
+// It also protects the hash chains and the LRU list.
 //
 // An ip->lock sleep-lock protects all ip-> fields other than ref,
-// dev, and inum.  One must hold ip->lock in order to
+// dev, inum and the list links.  One must hold ip->lock in order to
 // read or write that inode's ip->valid, ip->size, ip->type, &c.
+//
+// Entries are allocated from a slab as needed, up to a limit
+// chosen at boot from the amount of free memory (see
+// icacheinit); past it, the least recently used unreferenced
+// entry is recycled.  Entries are found by hashing (dev, inum)
+// rather than scanning the whole cache.
 
 struct {
   struct spinlock lock;
-  struct inode inode[NINODE];
+  struct slab slab;               // where entries come from
+  int ninode;                     // limit on cache entries
+  int nalloc;                     // entries allocated so far
+  struct inode *hash[NIHASH];     // chains through ip->hnext
+  // Unreferenced entries, through prev/next.
+  // lru.next is most recently used.
+  struct inode lru;
+  struct fsstat stat;
 } icache;
 
+#define IHASH(dev, inum) (((dev) * 31 + (inum)) % NIHASH)
+
+// Set up the inode cache.  Called once from main(),
+// after kinit2() and before the first namei().
 void
-iinit(int dev)
+icacheinit(void)
 {
-  int i = 0;
-  
   initlock(&icache.lock, "icache");
-  for(i = 0; i < NINODE; i++) {
-    initsleeplock(&icache.inode[i].lock, "inode");
-  }
+  slabinit(&icache.slab, "inode", sizeof(struct inode));
+  dcinit();
+  icache.lru.prev = &icache.lru;
+  icache.lru.next = &icache.lru;
+
+  icache.ninode = kfreepages() / 64;
+  if(icache.ninode < NINODE)
+    icache.ninode = NINODE;
+  if(icache.ninode > NINODEMAX)
+    icache.ninode = NINODEMAX;
+}
 
+void
+iinit(int dev)
+{
   readsb(dev, &sb);
   cprintf("sb: size %d nblocks %d ninodes %d nlog %d logstart %d\
  inodestart %d bmap start %d\n", sb.size, sb.nblocks,
           sb.ninodes, sb.nlog, sb.logstart, sb.inodestart,
           sb.bmapstart);
+  cprintf("icache: up to %d inodes\n", icache.ninode);
 }
 
 static struct inode* iget(uint dev, uint inum);
@@ -242,31 +280,52 @@ iupdate(struct inode *ip)
 static struct inode*
 iget(uint dev, uint inum)
 {
-  struct inode *ip, *empty;
+  struct inode *ip, **pp;
 
   acquire(&icache.lock);
 
   // Is the inode already cached?
-  empty = 0;
-  for(ip = &icache.inode[0]; ip < &icache.inode[NINODE]; ip++){
-    if(ip->ref > 0 && ip->dev == dev && ip->inum == inum){
-      ip->ref++;
+  for(ip = icache.hash[IHASH(dev, inum)]; ip; ip = ip->hnext){
+    if(ip->dev == dev && ip->inum == inum){
+      if(ip->ref++ == 0){
+        // Take it off the LRU list.
+        ip->next->prev = ip->prev;
+        ip->prev->next = ip->next;
+        if(ip->valid)
+          icache.stat.ireuse++;
+      }
       release(&icache.lock);
       return ip;
     }
-    if(empty == 0 && ip->ref == 0)    // Remember empty slot.
-      empty = ip;
   }
 
-  // Recycle an inode cache entry.
-  if(empty == 0)
+  // Allocate a new entry, or recycle the least recently
+  // used unreferenced one.
+  ip = 0;
+  if(icache.nalloc < icache.ninode && (ip = slaballoc(&icache.slab)) != 0){
+    memset(ip, 0, sizeof(*ip));
+    initsleeplock(&ip->lock, "inode");
+    icache.nalloc++;
+  } else if((ip = icache.lru.prev) != &icache.lru){
+    ip->next->prev = ip->prev;
+    ip->prev->next = ip->next;
+  } else
     panic("iget: no inodes");
+  if(ip->inum != 0){
+    for(pp = &icache.hash[IHASH(ip->dev, ip->inum)]; *pp; pp = &(*pp)->hnext){
+      if(*pp == ip){
+        *pp = ip->hnext;
+        break;
+      }
+    }
+  }
 
-  ip = empty;
   ip->dev = dev;
   ip->inum = inum;
   ip->ref = 1;
   ip->valid = 0;
+  ip->hnext = icache.hash[IHASH(dev, inum)];
+  icache.hash[IHASH(dev, inum)] = ip;
   release(&icache.lock);
 
   return ip;
@@ -297,6 +356,9 @@ ilock(struct inode *ip)
   acquiresleep(&ip->lock);
 
   if(ip->valid == 0){
+    acquire(&icache.lock);
+    icache.stat.ireads++;
+    release(&icache.lock);
     bp = bread(ip->dev, IBLOCK(ip->inum, sb));
     dip = (struct dinode*)bp->data + ip->inum%IPB;
     ip->type = dip->type;
@@ -306,6 +368,7 @@ ilock(struct inode *ip)
     ip->size = dip->size;
     memmove(ip->addrs, dip->addrs, sizeof(ip->addrs));
     brelse(bp);
+    ip->freeoff = 0;
     ip->valid = 1;
     if(ip->type == 0)
       panic("ilock: no type");
@@ -323,8 +386,8 @@ iunlock(struct inode *ip)
 }
 
 // Drop a reference to an in-memory inode.
-// If that was the last reference, the inode cache entry can
-// be recycled.
+// If that was the last reference, the inode cache entry
+// moves to the head of the LRU list and can be recycled.
 // If that was the last reference and the inode has no links
 // to it, free the inode (and its content) on disk.
 // All calls to iput() must be inside a transaction in
@@ -340,6 +403,8 @@ iput(struct inode *ip)
     if(r == 1){
       // inode has no links and no other references: truncate and free.
       itrunc(ip);
+      if(ip->type == T_DIR)
+        dcpurge(ip->dev, ip->inum);  // only directories have cached names
       ip->type = 0;
       iupdate(ip);
       ip->valid = 0;
@@ -348,10 +413,25 @@ iput(struct inode *ip)
   releasesleep(&ip->lock);
 
   acquire(&icache.lock);
-  ip->ref--;
+  if(--ip->ref == 0){
+    ip->next = icache.lru.next;
+    ip->prev = &icache.lru;
+    icache.lru.next->prev = ip;
+    icache.lru.next = ip;
+  }
   release(&icache.lock);
 }
 
+// Copy the file system cache statistics to *st.
+void
+getfsstat(struct fsstat *st)
+{
+  acquire(&icache.lock);
+  *st = icache.stat;
+  release(&icache.lock);
+  pcachestat(&st->phits, &st->pmisses);
+}
+
 // Common idiom: unlock, then put.
 void
 iunlockput(struct inode *ip)
@@ -433,6 +513,7 @@ itrunc(struct inode *ip)
 
   ip->size = 0;
   iupdate(ip);
+  pinval(ip->dev, ip->inum, 0, (MAXFILE*BSIZE - 1)/PGSIZE);
 }
 
 // Copy stat information from inode.
@@ -447,14 +528,44 @@ stati(struct inode *ip, struct stat *st)
   st->size = ip->size;
 }
 
+// Return page pgno of file ip from the page cache, reading
+// it from the file's blocks if necessary, or 0 if there is no
+// page to spare.  Blocks past the end of the file read as zeros.
+// Caller must hold ip->lock, and must pput() the page.
+struct page*
+igetpage(struct inode *ip, uint pgno)
+{
+  struct page *pg;
+  struct buf *bp;
+  uint bn;
+  int i;
+
+  if((pg = pget(ip->dev, ip->inum, pgno, 1)) == 0 || pg->valid)
+    return pg;
+  for(i = 0; i < PGSIZE/BSIZE; i++){
+    bn = pg->pgno * (PGSIZE/BSIZE) + i;
+    if(bn * BSIZE < ip->size){
+      bp = bread(ip->dev, bmap(ip, bn));
+      memmove(pg->data + i*BSIZE, bp->data, BSIZE);
+      brelse(bp);
+    } else
+      memset(pg->data + i*BSIZE, 0, BSIZE);
+  }
+  pg->valid = 1;
+  return pg;
+}
+
 //PAGEBREAK!
 // Read data from inode.
+// Regular files are read a page at a time through the page
+// cache, falling back to the buffer cache if no page is free.
 // Caller must hold ip->lock.
 int
 readi(struct inode *ip, char *dst, uint off, uint n)
 {
   uint tot, m;
   struct buf *bp;
+  struct page *pg;
 
   if(ip->type == T_DEV){
     if(ip->major < 0 || ip->major >= NDEV || !devsw[ip->major].read)
@@ -468,6 +579,12 @@ readi(struct inode *ip, char *dst, uint off, uint n)
     n = ip->size - off;
 
   for(tot=0; tot<n; tot+=m, off+=m, dst+=m){
+    if(ip->type == T_FILE && (pg = igetpage(ip, off/PGSIZE)) != 0){
+      m = min(n - tot, PGSIZE - off%PGSIZE);
+      memmove(dst, pg->data + off%PGSIZE, m);
+      pput(pg);
+      continue;
+    }
     bp = bread(ip->dev, bmap(ip, off/BSIZE));
     m = min(n - tot, BSIZE - off%BSIZE);
     memmove(dst, bp->data + off%BSIZE, m);
@@ -484,6 +601,7 @@ writei(struct inode *ip, char *src, uint off, uint n)
 {
   uint tot, m;
   struct buf *bp;
+  struct page *pg;
 
   if(ip->type == T_DEV){
     if(ip->major < 0 || ip->major >= NDEV || !devsw[ip->major].write)
@@ -502,6 +620,12 @@ writei(struct inode *ip, char *src, uint off, uint n)
     memmove(bp->data + off%BSIZE, src, m);
     log_write(bp);
     brelse(bp);
+    // Keep a cached copy of the page, which may be mapped, current.
+    if(ip->type == T_FILE && (pg = pget(ip->dev, ip->inum, off/PGSIZE, 0)) != 0){
+      if(pg->valid)
+        memmove(pg->data + off%PGSIZE, src, m);
+      pput(pg);
+    }
   }
 
   if(n > 0 && off > ip->size){
@@ -520,40 +644,215 @@ namecmp(const char *s, const char *t)
   return strncmp(s, t, DIRSIZ);
 }
 
+// Directory name cache.
+//
+// dirlookup() normally scans a directory one dirent at a time,
+// so every path element that namex() resolves costs a pass over
+// the directory. The dcache remembers recent (directory, name)
+// -> inum results, including names that are known to be absent
+// (inum == 0, a negative entry).
+//
+// Entries are keyed by the parent directory, and are only read
+// or changed by callers holding that directory's lock, so a miss
+// can scan the directory and insert the result without racing
+// dirlink() or unlink. dcache.lock only protects the table itself;
+// it is a reader-writer lock so that lookups in different
+// directories, by far the common case, do not serialize.
+
+struct dcentry {
+  uint dev;
+  uint dinum;             // inode number of the parent directory
+  char name[DIRSIZ];
+  uint inum;              // 0 if name is not in the directory
+  uint off;               // byte offset of the dirent, if inum != 0
+  int used;
+  struct dcentry *next;   // hash chain
+};
+
+struct {
+  struct rwlock lock;
+  struct dcentry entry[NDCACHE];
+  struct dcentry *hash[NDCHASH];
+  int hand;               // next entry to recycle
+} dcache;
+
+static void
+dcinit(void)
+{
+  initrwlock(&dcache.lock, "dcache");
+}
+
+static uint
+dchash(uint dev, uint dinum, char *name)
+{
+  uint h;
+  int i;
+
+  h = dev * 31 + dinum;
+  for(i = 0; i < DIRSIZ && name[i]; i++)
+    h = h * 31 + (uchar)name[i];
+  return h % NDCHASH;
+}
+
+// Find the entry for (dev, dinum, name).
+// Caller must hold dcache.lock.
+static struct dcentry*
+dcfind(uint dev, uint dinum, char *name)
+{
+  struct dcentry *e;
+
+  for(e = dcache.hash[dchash(dev, dinum, name)]; e; e = e->next)
+    if(e->dev == dev && e->dinum == dinum && namecmp(e->name, name) == 0)
+      return e;
+  return 0;
+}
+
+// Unlink e from its hash chain and mark it free.
+// Caller must hold dcache.lock.
+static void
+dcremove(struct dcentry *e)
+{
+  struct dcentry **pp;
+
+  for(pp = &dcache.hash[dchash(e->dev, e->dinum, e->name)]; *pp; pp = &(*pp)->next){
+    if(*pp == e){
+      *pp = e->next;
+      break;
+    }
+  }
+  e->next = 0;
+  e->used = 0;
+}
+
+// Look up name in directory dp in the dcache.
+// Returns 1 and fills in *inum and *off on a hit
+// (*inum is 0 for a negative entry), 0 on a miss.
+static int
+dclookup(struct inode *dp, char *name, uint *inum, uint *off)
+{
+  struct dcentry *e;
+
+  acquireread(&dcache.lock);
+  if((e = dcfind(dp->dev, dp->inum, name)) == 0){
+    releaseread(&dcache.lock);
+    return 0;
+  }
+  *inum = e->inum;
+  *off = e->off;
+  releaseread(&dcache.lock);
+  return 1;
+}
+
+// Record that name in directory dp refers to inum
+// at offset off, or is absent if inum is 0.
+static void
+dcinsert(struct inode *dp, char *name, uint inum, uint off)
+{
+  struct dcentry *e;
+  uint h;
+
+  acquirewrite(&dcache.lock);
+  if((e = dcfind(dp->dev, dp->inum, name)) == 0){
+    e = &dcache.entry[dcache.hand];
+    dcache.hand = (dcache.hand + 1) % NDCACHE;
+    if(e->used)
+      dcremove(e);
+    e->dev = dp->dev;
+    e->dinum = dp->inum;
+    strncpy(e->name, name, DIRSIZ);
+    e->used = 1;
+    h = dchash(e->dev, e->dinum, e->name);
+    e->next = dcache.hash[h];
+    dcache.hash[h] = e;
+  }
+  e->inum = inum;
+  e->off = off;
+  releasewrite(&dcache.lock);
+}
+
+// Forget name in directory dp.
+// Called when its directory entry is cleared.
+static void
+dcacheinval(struct inode *dp, char *name)
+{
+  struct dcentry *e;
+
+  acquirewrite(&dcache.lock);
+  if((e = dcfind(dp->dev, dp->inum, name)) != 0)
+    dcremove(e);
+  releasewrite(&dcache.lock);
+}
+
+// Forget every name cached for directory inode inum,
+// whose on-disk inode is being freed and may be reused.
+static void
+dcpurge(uint dev, uint inum)
+{
+  struct dcentry *e;
+
+  acquirewrite(&dcache.lock);
+  for(e = dcache.entry; e < &dcache.entry[NDCACHE]; e++)
+    if(e->used && e->dev == dev && e->dinum == inum)
+      dcremove(e);
+  releasewrite(&dcache.lock);
+}
+
 // Look for a directory entry in a directory.
 // If found, set *poff to byte offset of entry.
+// Scans each directory block in place in the buffer cache
+// rather than copying the entries out one at a time.
 struct inode*
 dirlookup(struct inode *dp, char *name, uint *poff)
 {
-  uint off, inum;
-  struct dirent de;
+  uint off, inum, m;
+  struct buf *bp;
+  struct dirent *de, *ede;
 
   if(dp->type != T_DIR)
     panic("dirlookup not DIR");
 
-  for(off = 0; off < dp->size; off += sizeof(de)){
-    if(readi(dp, (char*)&de, off, sizeof(de)) != sizeof(de))
-      panic("dirlookup read");
-    if(de.inum == 0)
-      continue;
-    if(namecmp(name, de.name) == 0){
-      // entry matches path element
-      if(poff)
-        *poff = off;
-      inum = de.inum;
-      return iget(dp->dev, inum);
+  if(dclookup(dp, name, &inum, &off)){
+    if(inum == 0)
+      return 0;
+    if(poff)
+      *poff = off;
+    return iget(dp->dev, inum);
+  }
+
+  for(off = 0; off < dp->size; off += m){
+    bp = bread(dp->dev, bmap(dp, off/BSIZE));
+    m = min(dp->size - off, BSIZE);
+    ede = (struct dirent*)(bp->data + m);
+    for(de = (struct dirent*)bp->data; de < ede; de++){
+      if(de->inum == 0)
+        continue;
+      if(namecmp(name, de->name) == 0){
+        // entry matches path element
+        off += (char*)de - (char*)bp->data;
+        inum = de->inum;
+        brelse(bp);
+        if(poff)
+          *poff = off;
+        dcinsert(dp, name, inum, off);
+        return iget(dp->dev, inum);
+      }
     }
+    brelse(bp);
   }
 
+  dcinsert(dp, name, 0, 0);
   return 0;
 }
 
 // Write a new directory entry (name, inum) into the directory dp.
+// The search for a free slot starts at dp->freeoff, below
+// which every dirent is known to be in use.
 int
 dirlink(struct inode *dp, char *name, uint inum)
 {
-  int off;
-  struct dirent de;
+  uint off, m;
+  struct buf *bp;
+  struct dirent *de, *sde, nde;
   struct inode *ip;
 
   // Check that name is not present.
@@ -562,22 +861,51 @@ dirlink(struct inode *dp, char *name, uint inum)
     return -1;
   }
 
-  // Look for an empty dirent.
-  for(off = 0; off < dp->size; off += sizeof(de)){
-    if(readi(dp, (char*)&de, off, sizeof(de)) != sizeof(de))
-      panic("dirlink read");
-    if(de.inum == 0)
-      break;
+  // Look for an empty dirent, and fill it in place if found.
+  for(off = dp->freeoff; off < dp->size; off += m){
+    bp = bread(dp->dev, bmap(dp, off/BSIZE));
+    m = min(dp->size - off, BSIZE - off%BSIZE);
+    sde = (struct dirent*)(bp->data + off%BSIZE);
+    for(de = sde; de < sde + m/sizeof(*de); de++){
+      if(de->inum == 0){
+        off += (de - sde) * sizeof(*de);
+        strncpy(de->name, name, DIRSIZ);
+        de->inum = inum;
+        log_write(bp);
+        brelse(bp);
+        goto done;
+      }
+    }
+    brelse(bp);
   }
 
-  strncpy(de.name, name, DIRSIZ);
-  de.inum = inum;
-  if(writei(dp, (char*)&de, off, sizeof(de)) != sizeof(de))
+  // No free slot: append to the directory.
+  strncpy(nde.name, name, DIRSIZ);
+  nde.inum = inum;
+  if(writei(dp, (char*)&nde, off, sizeof(nde)) != sizeof(nde))
     panic("dirlink");
 
+done:
+  dp->freeoff = off + sizeof(nde);
+  dcinsert(dp, name, inum, off);
   return 0;
 }
 
+// Remove the entry for name, found at byte offset off,
+// from the directory dp. Caller must hold dp->lock.
+void
+dirunlink(struct inode *dp, char *name, uint off)
+{
+  struct dirent de;
+
+  memset(&de, 0, sizeof(de));
+  if(writei(dp, (char*)&de, off, sizeof(de)) != sizeof(de))
+    panic("dirunlink");
+  if(off < dp->freeoff)
+    dp->freeoff = off;
+  dcacheinval(dp, name);
+}
+
 //PAGEBREAK!
 // Paths
 
@@ -630,7 +958,7 @@ namex(char *path, int nameiparent, char *name)
   if(*path == '/')
     ip = iget(ROOTDEV, ROOTINO);
   else
-    ip = idup(myproc()->cwd);
+    ip = fdcwd(myproc()->fdt);
 
   while((path = skipelem(path, name)) != 0){
     ilock(ip);
@@ -0,0 +1,9 @@
+// File system cache statistics, returned by the fsstat() system call.
+struct fsstat
+{
+  uint ireads;      // ilock() calls that had to read the inode from disk
+  uint ireuse;      // iget() hits on an unreferenced but still valid inode,
+                    // i.e. ilock() disk reads avoided by the LRU list
+  uint phits;       // readi() pages found in the page cache
+  uint pmisses;     // readi() pages filled from the buffer cache
+};
@@ -0,0 +1,142 @@
+// Try to game the scheduler.  Gamers run for half a tick and
+// then sleep, so that they are never running when the timer
+// ticks; before allotments were charged across sleeps, that
+// kept them in q0 for good.  Alongside them run CPU hogs and
+// an interactive process that sleeps for a tick at a time.
+//
+// Checks that the gamers end up running mostly in q2, and
+// that the interactive process's sleep(1) calls never take
+// more than a couple of ticks longer than the tick they sleep
+// for, with the hogs alone and with the gamers too.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "x86.h"
+#include "pstat.h"
+
+#define NHOGS    2
+#define NGAMERS  2
+#define NSLEEPS  200
+#define MAXSLEEP (3 * TICKUS)   // longest sleep(1) allowed, microseconds
+
+static struct pstat ps;
+static void
+spin(uint cycles)
+{
+  uint64 t0;
+
+  t0 = rdtsc();
+  while((uint)(rdtsc() - t0) < cycles)
+    ;
+}
+
+static void
+gamer(void)
+{
+  for(;;){
+    sleep(1);
+    spin(tickcycles() / 2);
+  }
+}
+
+static void
+hog(void)
+{
+  for(;;)
+    ;
+}
+
+// Time NSLEEPS sleep(1) calls, in microseconds.
+static void
+interactive(uint *avg, uint *max)
+{
+  uint64 t0;
+  uint us, tot;
+  int i;
+
+  tot = *max = 0;
+  for(i = 0; i < NSLEEPS; i++){
+    t0 = rdtsc();
+    sleep(1);
+    us = cyclestous(rdtsc() - t0);
+    tot += us;
+    if(us > *max)
+      *max = us;
+  }
+  *avg = tot / NSLEEPS;
+}
+
+// Print where pid has run and return the percentage of its
+// CPU time it ran in q2.
+static int
+report(char *what, int pid)
+{
+  int tot;
+
+  if(getpstat(pid, &ps) < 0){
+    printf(1, "gamebench: getpstat %d failed\n", pid);
+    return 0;
+  }
+  tot = ps.runtime[0] + ps.runtime[1] + ps.runtime[2];
+  printf(1, "  %s %d: ran %d ms (q0 %d, q1 %d, q2 %d)\n", what, pid,
+         tot / 1000, ps.runtime[0] / 1000, ps.runtime[1] / 1000,
+         ps.runtime[2] / 1000);
+  return tot ? ps.runtime[2] / (tot / 100 + 1) : 0;
+}
+
+static int
+run(int ngamers)
+{
+  int pids[NHOGS + NGAMERS];
+  uint avg, max;
+  int i, n, pct, ok;
+
+  n = 0;
+  for(i = 0; i < NHOGS; i++)
+    if((pids[n++] = fork()) == 0)
+      hog();
+  for(i = 0; i < ngamers; i++)
+    if((pids[n++] = fork()) == 0)
+      gamer();
+
+  interactive(&avg, &max);
+  printf(1, "%d hogs, %d gamers: sleep(1) took avg %d us, max %d us\n",
+         NHOGS, ngamers, avg, max);
+
+  ok = 1;
+  if(max > MAXSLEEP){
+    printf(1, "gamebench: sleep(1) took %d us, over %d us\n", max, MAXSLEEP);
+    ok = 0;
+  }
+  for(i = 0; i < n; i++){
+    pct = report(i < NHOGS ? "hog" : "gamer", pids[i]);
+    if(i >= NHOGS && pct < 50){
+      printf(1, "gamebench: gamer %d ran only %d%% of its time in q2\n",
+             pids[i], pct);
+      ok = 0;
+    }
+  }
+  for(i = 0; i < n; i++){
+    kill(pids[i]);
+    wait();
+  }
+  return ok;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int ok;
+
+  printf(1, "gamebench starting\n");
+  tickcycles();
+  ok = run(0);
+  ok &= run(NGAMERS);
+  if(ok)
+    printf(1, "gamebench ok\n");
+  else
+    printf(1, "gamebench FAILED\n");
+  exit();
+}
@@ -3,9 +3,45 @@
 #include "types.h"
 #include "stat.h"
 #include "user.h"
+#include "mman.h"
 
 char buf[1024];
 int match(char*, char*);
+int usemmap;  // -m: map the file instead of reading it
+
+// Grep a file mapped privately, so that lines can be
+// terminated in place without copying them.
+// Returns -1 if fd cannot be mapped.
+int
+grepmap(char *pattern, int fd)
+{
+  struct stat st;
+  char *p, *q, *e, *map;
+
+  if(fstat(fd, &st) < 0 || st.type != T_FILE)
+    return -1;
+  if(st.size == 0)
+    return 0;
+  // One spare byte past the end for a final unterminated line.
+  map = mmap(0, st.size + 1, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if(map == MAP_FAILED)
+    return -1;
+  e = map + st.size;
+  for(p = map; p < e; p = q+1){
+    for(q = p; q < e && *q != '\n'; q++)
+      ;
+    *q = 0;
+    if(match(pattern, p)){
+      if(q < e){
+        *q = '\n';
+        write(1, p, q+1 - p);
+      } else
+        write(1, p, q - p);
+    }
+  }
+  munmap(map, st.size + 1);
+  return 0;
+}
 
 void
 grep(char *pattern, int fd)
@@ -42,22 +78,32 @@ main(int argc, char *argv[])
   char *pattern;
 
   if(argc <= 1){
-    printf(2, "usage: grep pattern [file ...]\n");
+    printf(2, "usage: grep [-m] pattern [file ...]\n");
+    exit();
+  }
+  i = 1;
+  if(strcmp(argv[1], "-m") == 0){
+    usemmap = 1;
+    i++;
+  }
+  if(i >= argc){
+    printf(2, "usage: grep [-m] pattern [file ...]\n");
     exit();
   }
-  pattern = argv[1];
+  pattern = argv[i++];
 
-  if(argc <= 2){
+  if(i >= argc){
     grep(pattern, 0);
     exit();
   }
 
-  for(i = 2; i < argc; i++){
+  for(; i < argc; i++){
     if((fd = open(argv[i], 0)) < 0){
       printf(1, "grep: cannot open %s\n", argv[i]);
       exit();
     }
-    grep(pattern, fd);
+    if(!usemmap || grepmap(pattern, fd) < 0)
+      grep(pattern, fd);
     close(fd);
   }
   exit();
@@ -0,0 +1,202 @@
+// Inter-processor interrupts.
+//
+// T_IPIRESCHED asks a CPU to reschedule: its handler does
+// nothing, and trap() notices cpu->resched on the way out.
+// T_IPICALL asks a CPU to run the functions that other CPUs
+// have queued for it with ipicall().  Calls are synchronous,
+// so each queue entry lives on its caller's stack.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "x86.h"
+#include "traps.h"
+#include "proc.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "vmspace.h"
+
+#define NIPICALL 16      // calls queued per CPU
+
+struct ipicall {
+  void (*fn)(void *);
+  void *arg;
+  volatile int done;
+};
+
+struct {
+  struct spinlock lock;
+  struct ipicall *call[NIPICALL];
+  int n;
+} ipiq[NCPU];
+
+void
+ipiinit(void)
+{
+  int i;
+
+  for(i = 0; i < NCPU; i++)
+    initlock(&ipiq[i].lock, "ipiq");
+}
+
+// Ask c to reschedule.
+void
+ipiresched(struct cpu *c)
+{
+  pushcli();
+  if(c != mycpu())
+    lapicipi(c->apicid, T_IPIRESCHED);
+  popcli();
+}
+
+// Run the calls queued for this CPU.  Called from the
+// T_IPICALL handler, and by CPUs waiting for their own calls
+// so that two CPUs calling each other do not deadlock.
+// Interrupts must be off.
+void
+ipipoll(void)
+{
+  struct ipicall *call;
+  int cpu;
+
+  cpu = cpuid();
+  while(*(volatile int*)&ipiq[cpu].n > 0){
+    acquire(&ipiq[cpu].lock);
+    if(ipiq[cpu].n == 0){
+      release(&ipiq[cpu].lock);
+      break;
+    }
+    call = ipiq[cpu].call[--ipiq[cpu].n];
+    release(&ipiq[cpu].lock);
+    call->fn(call->arg);
+    __sync_synchronize();
+    call->done = 1;
+  }
+}
+
+// Put call on cpu's queue.  Interrupts must be off.
+static void
+enqueue(int cpu, struct ipicall *call)
+{
+  for(;;){
+    acquire(&ipiq[cpu].lock);
+    if(ipiq[cpu].n < NIPICALL)
+      break;
+    release(&ipiq[cpu].lock);
+    ipipoll();
+  }
+  call->done = 0;
+  ipiq[cpu].call[ipiq[cpu].n++] = call;
+  release(&ipiq[cpu].lock);
+}
+
+// Run fn(arg) on cpu and wait for it to finish.
+// fn runs in interrupt context and must not sleep.  The
+// caller must not hold a spinlock, which the other CPU might
+// be spinning on with interrupts off.
+int
+ipicall(int cpu, void (*fn)(void *), void *arg)
+{
+  struct ipicall call;
+
+  if(cpu < 0 || cpu >= ncpu)
+    return -1;
+  pushcli();
+  if(cpu == cpuid()){
+    fn(arg);
+    popcli();
+    return 0;
+  }
+  call.fn = fn;
+  call.arg = arg;
+  enqueue(cpu, &call);
+  lapicipi(cpus[cpu].apicid, T_IPICALL);
+  while(!call.done)
+    ipipoll();
+  popcli();
+  return 0;
+}
+
+// Run fn(arg) on every other CPU and wait for all of them.
+void
+ipicallall(void (*fn)(void *), void *arg)
+{
+  struct ipicall call[NCPU];
+  int i, self;
+
+  pushcli();
+  self = cpuid();
+  for(i = 0; i < ncpu; i++){
+    if(i == self)
+      continue;
+    call[i].fn = fn;
+    call[i].arg = arg;
+    enqueue(i, &call[i]);
+  }
+  lapicipi(-1, T_IPICALL);
+  for(i = 0; i < ncpu; i++)
+    while(i != self && !call[i].done)
+      ipipoll();
+  popcli();
+}
+
+static void
+flushtlb(void *pgdir)
+{
+  if(rcr3() == V2P(pgdir))
+    lcr3(V2P(pgdir));
+}
+
+// Make other CPUs running in address space vm drop their
+// stale TLB entries, after the caller has removed or changed
+// mappings in it.  A CPU that switches to vm later loads
+// %cr3 afresh, so it is enough to ask the ones on it now.
+void
+tlbshootdown(struct vmspace *vm)
+{
+  struct proc *p;
+  int i, self;
+
+  pushcli();
+  self = cpuid();
+  for(i = 0; i < ncpu; i++){
+    p = cpus[i].proc;
+    if(i != self && p && p->vm == vm)
+      ipicall(i, flushtlb, vm->pgdir);
+  }
+  popcli();
+}
+
+static void
+ipinop(void *arg)
+{
+}
+
+// Time n round trips of an empty call to cpu, for ipibench.
+// Returns the average in TSC cycles, or -1 if cpu is this
+// CPU or does not exist.
+int
+ipiping(int cpu, int n)
+{
+  uint64 t0;
+  uint tot;
+  int i;
+
+  if(n <= 0 || cpu < 0 || cpu >= ncpu)
+    return -1;
+  pushcli();
+  if(cpu == cpuid()){
+    popcli();
+    return -1;
+  }
+  tot = 0;
+  for(i = 0; i < n; i++){
+    t0 = rdtsc();
+    ipicall(cpu, ipinop, 0);
+    tot += (uint)(rdtsc() - t0);
+  }
+  popcli();
+  return tot / n;
+}
@@ -0,0 +1,36 @@
+// Time inter-processor interrupt round trips: the kernel
+// queues an empty call for another CPU, interrupts it, and
+// waits for the call to finish.  Run with make CPUS=2 or more.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+
+#define ROUNDS 10000
+
+int
+main(int argc, char *argv[])
+{
+  uint us;
+  int cpu, cycles, n;
+
+  printf(1, "ipibench starting\n");
+
+  us = uscycles();
+
+  n = 0;
+  for(cpu = 0; cpu < NCPU; cpu++){
+    // Fails for the CPU we are running on, and for CPUs
+    // that do not exist.
+    if((cycles = ipiping(cpu, ROUNDS)) < 0)
+      continue;
+    printf(1, "to cpu %d: %d cycles (%d.%d us) per round trip\n",
+           cpu, cycles, cycles / us, cycles * 10 / us % 10);
+    n++;
+  }
+  if(n == 0)
+    printf(1, "ipibench: no other CPUs; run with make CPUS=2\n");
+  printf(1, "ipibench ok\n");
+  exit();
+}
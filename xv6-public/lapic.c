@@ -26,6 +26,7 @@
   #define DEASSERT   0x00000000
   #define LEVEL      0x00008000   // Level triggered
   #define BCAST      0x00080000   // Send to all APICs, including self.
+  #define OTHERS     0x000C0000   // Send to all APICs, excluding self.
   #define BUSY       0x00001000
   #define FIXED      0x00000000
 #define ICRHI   (0x0310/4)   // Interrupt Command [63:32]
@@ -41,7 +42,11 @@
 #define TCCR    (0x0390/4)   // Timer Current Count
 #define TDCR    (0x03E0/4)   // Timer Divide Configuration
 
+#define TIMERCOUNT 10000000  // bus cycles per timer tick
+
 volatile uint *lapic;  // Initialized in mp.c
+uint tickcycles;       // TSC cycles per timer tick
+static uint uscycles;  // TSC cycles per microsecond
 
 //PAGEBREAK!
 static void
@@ -51,6 +56,38 @@ lapicw(int index, int value)
   lapic[ID];  // wait for write to finish, by reading
 }
 
+// Count the TSC cycles in one timer tick, so that the
+// scheduler can account CPU time more finely than in ticks.
+// Times 1/8 of a tick, after waiting for the counter to
+// reload so that it does not wrap during the measurement.
+static void
+calibrate(void)
+{
+  uint c, c0;
+  uint64 t0;
+
+  c0 = lapic[TCCR];
+  while((c = lapic[TCCR]) <= c0)
+    c0 = c;
+  t0 = rdtsc();
+  while(lapic[TCCR] > c - TIMERCOUNT/8)
+    ;
+  tickcycles = (uint)(rdtsc() - t0) * 8;
+  uscycles = tickcycles / TICKUS;
+}
+
+// Convert a TSC interval to microseconds.  Before the TSC is
+// calibrated, call every interval a whole tick.
+uint
+tsc2us(uint64 cycles)
+{
+  if(uscycles == 0)
+    return TICKUS;
+  if(cycles >> 32)
+    return ~0U / uscycles;
+  return (uint)cycles / uscycles;
+}
+
 void
 lapicinit(void)
 {
@@ -66,7 +103,9 @@ lapicinit(void)
   // TICR would be calibrated using an external time source.
   lapicw(TDCR, X1);
   lapicw(TIMER, PERIODIC | (T_IRQ0 + IRQ_TIMER));
-  lapicw(TICR, 10000000);
+  lapicw(TICR, TIMERCOUNT);
+  if(tickcycles == 0)
+    calibrate();
 
   // Disable logical interrupt lines.
   lapicw(LINT0, MASKED);
@@ -113,6 +152,26 @@ lapiceoi(void)
     lapicw(EOI, 0);
 }
 
+// Send interrupt vector to the CPU with the given APIC ID,
+// or to every other CPU if apicid is -1.
+// Caller must have interrupts off, so that an interrupt
+// handler cannot send an IPI of its own halfway through.
+void
+lapicipi(int apicid, int vector)
+{
+  if(!lapic)
+    return;
+  if(apicid < 0){
+    lapicw(ICRHI, 0);
+    lapicw(ICRLO, OTHERS | FIXED | ASSERT | vector);
+  } else {
+    lapicw(ICRHI, apicid<<24);
+    lapicw(ICRLO, FIXED | ASSERT | vector);
+  }
+  while(lapic[ICRLO] & DELIVS)
+    ;
+}
+
 // Spin for a given number of microseconds.
 // On real hardware would want to tune this dynamically.
 void
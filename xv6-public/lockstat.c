@@ -0,0 +1,83 @@
+// Print kernel lock statistics.
+//
+//   lockstat [-n N] [command [arg ...]]
+//
+// With a command, reset the statistics, run the command and
+// report what it caused.  Prints the N (default 10) locks that
+// spent the most time waiting, with histograms of wait and hold
+// times: "4^k:n" means n times were below 4^k cycles.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "lockstat.h"
+
+#define MAXLOCKS 64
+
+struct lockstat ls[MAXLOCKS];
+
+void
+hist(char *what, uint *h)
+{
+  int b;
+
+  printf(1, "    %s", what);
+  for(b = 0; b < NLOCKHIST; b++)
+    if(h[b])
+      printf(1, " 4^%d:%d", b+1, h[b]);
+  printf(1, "\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct lockstat t;
+  int i, j, n, top, pid;
+
+  top = 10;
+  i = 1;
+  if(argc > 2 && strcmp(argv[1], "-n") == 0){
+    top = atoi(argv[2]);
+    i = 3;
+  }
+
+  if(i < argc){
+    lockstat(-1, 0);
+    pid = fork();
+    if(pid < 0){
+      printf(2, "lockstat: fork failed\n");
+      exit();
+    }
+    if(pid == 0){
+      exec(argv[i], argv + i);
+      printf(2, "lockstat: exec %s failed\n", argv[i]);
+      exit();
+    }
+    wait();
+  }
+
+  // Collect the locks that were used, most time waiting first.
+  for(n = 0; n < MAXLOCKS && lockstat(n, &ls[n]) == 0; n++)
+    ;
+  for(i = 1; i < n; i++){
+    t = ls[i];
+    for(j = i; j > 0 && (ls[j-1].wait < t.wait ||
+        (ls[j-1].wait == t.wait && ls[j-1].ncontended < t.ncontended)); j--)
+      ls[j] = ls[j-1];
+    ls[j] = t;
+  }
+
+  printf(1, "name             type   acquire  contended  wait(Kcyc)  maxhold(cyc)\n");
+  for(i = 0; i < n && i < top; i++){
+    if(ls[i].nacquire == 0)
+      break;
+    printf(1, "%s", ls[i].name);
+    for(j = strlen(ls[i].name); j < 16; j++)
+      printf(1, " ");
+    printf(1, " %s  %d  %d  %d  %d\n", ls[i].sleep ? "sleep" : "spin ",
+           ls[i].nacquire, ls[i].ncontended, ls[i].wait, ls[i].maxhold);
+    hist("wait", ls[i].waithist);
+    hist("hold", ls[i].holdhist);
+  }
+  exit();
+}
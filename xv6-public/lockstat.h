@@ -0,0 +1,15 @@
+#define NLOCKHIST 16  // histogram buckets: bucket b counts times below 4^(b+1) cycles
+
+// Statistics for the locks of one name, summed over CPUs,
+// returned by the lockstat() system call.
+struct lockstat
+{
+  char name[16];
+  int sleep;        // a sleep lock, not a spinlock
+  uint nacquire;    // acquisitions
+  uint ncontended;  // acquisitions that had to spin or sleep
+  uint wait;        // cycles spent waiting, in units of 1024
+  uint maxhold;     // longest hold in cycles, saturating
+  uint waithist[NLOCKHIST];  // acquisitions by cycles waited
+  uint holdhist[NLOCKHIST];  // releases by cycles held
+};
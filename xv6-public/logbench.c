@@ -0,0 +1,123 @@
+// Append log records made of a header, a message and a
+// newline to a file, with one write() per fragment and
+// with one writev() per record.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "uio.h"
+
+#define NRECORDS 1000
+
+char *msg = "request served from the page cache";
+
+// Format "[nnnn] " for record i into hdr.
+int
+header(char *hdr, int i)
+{
+  hdr[0] = '[';
+  hdr[1] = '0' + i / 1000 % 10;
+  hdr[2] = '0' + i / 100 % 10;
+  hdr[3] = '0' + i / 10 % 10;
+  hdr[4] = '0' + i % 10;
+  hdr[5] = ']';
+  hdr[6] = ' ';
+  return 7;
+}
+
+void
+run(int vectored)
+{
+  struct iovec iov[3];
+  struct stat st;
+  char hdr[8];
+  int fd, i, n, s0, s1, t0, t1;
+
+  unlink("lbfile");
+  if((fd = open("lbfile", O_CREATE | O_RDWR)) < 0){
+    printf(1, "logbench: create lbfile failed\n");
+    exit();
+  }
+  s0 = syscount(0);
+  t0 = uptime();
+  for(i = 0; i < NRECORDS; i++){
+    n = header(hdr, i);
+    if(vectored){
+      iov[0].iov_base = hdr;
+      iov[0].iov_len = n;
+      iov[1].iov_base = msg;
+      iov[1].iov_len = strlen(msg);
+      iov[2].iov_base = "\n";
+      iov[2].iov_len = 1;
+      if(writev(fd, iov, 3) != n + strlen(msg) + 1){
+        printf(1, "logbench: writev failed\n");
+        exit();
+      }
+    } else {
+      if(write(fd, hdr, n) != n || write(fd, msg, strlen(msg)) != strlen(msg) ||
+         write(fd, "\n", 1) != 1){
+        printf(1, "logbench: write failed\n");
+        exit();
+      }
+    }
+  }
+  t1 = uptime();
+  s1 = syscount(0);
+  if(fstat(fd, &st) < 0 || st.size != NRECORDS * (7 + strlen(msg) + 1)){
+    printf(1, "logbench: wrong log size\n");
+    exit();
+  }
+  close(fd);
+  printf(1, "%s: %d records, %d syscalls, %d ticks\n",
+         vectored ? "writev" : "write", NRECORDS, s1 - s0, t1 - t0);
+}
+
+int
+same(char *a, char *b, int n)
+{
+  while(n-- > 0)
+    if(*a++ != *b++)
+      return 0;
+  return 1;
+}
+
+// Read the log back with readv() into a header and a body
+// buffer per record and check the header.
+void
+check(void)
+{
+  struct iovec iov[2];
+  char hdr[8], want[8], body[64];
+  int fd, i, n;
+
+  if((fd = open("lbfile", O_RDONLY)) < 0){
+    printf(1, "logbench: open lbfile failed\n");
+    exit();
+  }
+  n = strlen(msg) + 1;
+  for(i = 0; i < NRECORDS; i++){
+    iov[0].iov_base = hdr;
+    iov[0].iov_len = 7;
+    iov[1].iov_base = body;
+    iov[1].iov_len = n;
+    header(want, i);
+    if(readv(fd, iov, 2) != 7 + n || !same(hdr, want, 7) || body[n-1] != '\n'){
+      printf(1, "logbench: readv record %d wrong\n", i);
+      exit();
+    }
+  }
+  close(fd);
+}
+
+int
+main(int argc, char *argv[])
+{
+  printf(1, "logbench starting\n");
+  run(0);
+  run(1);
+  check();
+  unlink("lbfile");
+  printf(1, "logbench ok\n");
+  exit();
+}
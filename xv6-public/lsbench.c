@@ -0,0 +1,59 @@
+// Run a shell script that invokes ls NRUN times and report
+// how many inode disk reads the inode cache's LRU list avoided.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "fsstat.h"
+
+#define NRUN 100
+
+char *line = "ls > lsout\n";
+
+int
+main(int argc, char *argv[])
+{
+  struct fsstat st0, st1;
+  char *shargv[] = { "sh", 0 };
+  int fd, i, pid, t0, t1;
+
+  printf(1, "lsbench starting\n");
+
+  if((fd = open("lsscript", O_CREATE | O_RDWR)) < 0){
+    printf(1, "lsbench: cannot create lsscript\n");
+    exit();
+  }
+  for(i = 0; i < NRUN; i++)
+    write(fd, line, strlen(line));
+  close(fd);
+
+  fsstat(&st0);
+  t0 = uptime();
+  pid = fork();
+  if(pid < 0){
+    printf(1, "lsbench: fork failed\n");
+    exit();
+  }
+  if(pid == 0){
+    close(0);
+    if(open("lsscript", O_RDONLY) != 0){
+      printf(1, "lsbench: cannot open lsscript\n");
+      exit();
+    }
+    exec("sh", shargv);
+    printf(1, "lsbench: exec sh failed\n");
+    exit();
+  }
+  wait();
+  t1 = uptime();
+  fsstat(&st1);
+
+  printf(1, "\nls x %d: %d ticks\n", NRUN, t1 - t0);
+  printf(1, "ilock disk reads: %d\n", st1.ireads - st0.ireads);
+  printf(1, "ilock disk reads avoided: %d\n", st1.ireuse - st0.ireuse);
+
+  unlink("lsscript");
+  unlink("lsout");
+  exit();
+}
@@ -0,0 +1,123 @@
+// Exercise malloc/free with a random mix of sizes and with
+// a producer/consumer queue, checking that live objects are
+// not overwritten.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NSLOTS 1000
+#define NOPS   100000
+#define QLEN   256
+
+char *slot[NSLOTS];
+uint slotsz[NSLOTS];
+uint seed = 1;
+
+uint
+rand(void)
+{
+  seed = seed * 1103515245 + 12345;
+  return (seed >> 16) & 0x7fff;
+}
+
+// Mostly small sizes, with an occasional large one.
+uint
+randsize(void)
+{
+  uint r;
+
+  r = rand();
+  if(r % 64 == 0)
+    return 2048 + r % 8192;
+  return 1 + r % (8 << (r % 8));
+}
+
+void
+fill(char *p, uint n, int tag)
+{
+  memset(p, tag, n);
+}
+
+void
+check(char *p, uint n, int tag)
+{
+  uint i;
+
+  for(i = 0; i < n; i++){
+    if(p[i] != (char)tag){
+      printf(1, "mallocbench: object %p overwritten\n", p);
+      exit();
+    }
+  }
+}
+
+void
+randommix(void)
+{
+  int i, k, t0, t1;
+
+  t0 = uptime();
+  for(i = 0; i < NOPS; i++){
+    k = rand() % NSLOTS;
+    if(slot[k]){
+      check(slot[k], slotsz[k] < 16 ? slotsz[k] : 16, k);
+      free(slot[k]);
+      slot[k] = 0;
+    } else {
+      slotsz[k] = randsize();
+      if((slot[k] = malloc(slotsz[k])) == 0){
+        printf(1, "mallocbench: malloc(%d) failed\n", slotsz[k]);
+        exit();
+      }
+      fill(slot[k], slotsz[k] < 16 ? slotsz[k] : 16, k);
+    }
+  }
+  for(k = 0; k < NSLOTS; k++){
+    free(slot[k]);
+    slot[k] = 0;
+  }
+  t1 = uptime();
+  printf(1, "random mix: %d operations, %d ticks\n", NOPS, t1 - t0);
+}
+
+void
+prodcons(void)
+{
+  char *q[QLEN];
+  int i, head, tail, t0, t1;
+  uint n;
+
+  head = tail = 0;
+  t0 = uptime();
+  for(i = 0; i < NOPS; i++){
+    // Produce in bursts, consume oldest first.
+    if(head - tail < QLEN && (rand() % 4 != 0 || head == tail)){
+      n = 16 + rand() % 240;
+      if((q[head % QLEN] = malloc(n)) == 0){
+        printf(1, "mallocbench: malloc(%d) failed\n", n);
+        exit();
+      }
+      fill(q[head % QLEN], 16, head & 0x7f);
+      head++;
+    } else {
+      check(q[tail % QLEN], 16, tail & 0x7f);
+      free(q[tail % QLEN]);
+      tail++;
+    }
+  }
+  while(tail < head)
+    free(q[tail++ % QLEN]);
+  t1 = uptime();
+  printf(1, "producer/consumer: %d operations, %d ticks\n", NOPS, t1 - t0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  printf(1, "mallocbench starting\n");
+  randommix();
+  prodcons();
+  printf(1, "mallocbench ok\n");
+  exit();
+}
@@ -0,0 +1,342 @@
+// MLFQ scheduling policy: three round-robin queues with time
+// slices of 1, 2 and 8 ticks.  Each queue's slice is also the
+// CPU time a process may use at that level in total: once it
+// has, it moves down a queue, whether it ran the time in one
+// slice or gave up the CPU along the way.  Otherwise a process
+// that sleeps just before every tick would never be demoted.
+// A process that has been scheduled BOOSTTICKS times in q2
+// moves back to q0.
+//
+// A process's nice value scales its slices and allotments, and
+// its top level, if set, is the highest queue it may be in.
+//
+// This file has no locking and touches only the fields of
+// struct proc listed in mlfq.h, so that it can also be built
+// on the host (with -DMLFQSIM) into mlfqsim.  In the kernel,
+// callers hold ptable.lock, and the policy is reached through
+// mlfqclass, at the end of the file.
+
+#ifdef MLFQSIM
+#include "mlfqsim.h"
+#else
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "mmu.h"
+#include "x86.h"
+#include "proc.h"
+#endif
+
+struct pqueue q0;
+struct pqueue q1;
+struct pqueue q2;
+
+void initQueues(void)
+{
+  q0.end = 0;
+  q0.numOfProc = 0;
+  q0.ticks = 1;
+  q0.priority = 0;
+
+  q1.end = 0;
+  q1.numOfProc = 0;
+  q1.ticks = 2;
+  q1.priority = 1;
+
+  q2.end = 0;
+  q2.numOfProc = 0;
+  q2.ticks = 8;
+  q2.priority = 2;
+}
+
+
+//Can p run on this CPU now?
+static int runnableHere(struct proc *p)
+{
+  return p->state == RUNNABLE && cpuPreference(p) >= 0;
+}
+
+//Return highest non-empty priorty queue with ready process
+struct pqueue *returnQueue(void)
+{
+  if (q0.numOfProc)
+  {
+    for (int i = 0; i < q0.end; i++)
+    {
+      if (runnableHere(q0.queue[i]))
+      {
+        return &q0;
+      }
+    }
+  }
+
+  if (q1.numOfProc)
+  {
+    for (int i = 0; i < q1.end; i++)
+    {
+      if (runnableHere(q1.queue[i]))
+      {
+        return &q1;
+      }
+    }
+  }
+
+  if (q2.numOfProc)
+  {
+    for (int i = 0; i < q2.end; i++)
+    {
+      if (runnableHere(q2.queue[i]))
+      {
+        return &q2;
+      }
+    }
+  }
+  //cprintf("No runnable processes");
+  return &q0;
+}
+
+//Adds process to end of specified priority queue
+void addQueue(struct pqueue *pq, struct proc *p)
+{
+
+  pq->queue[pq->end] = p;
+  pq->end++;
+  pq->numOfProc++;
+
+  p->priority = pq->priority;
+}
+
+//Weight of each nice value from NICEMIN to NICEMAX: nice 0
+//is 1024, and each step is about 25% (the weights Linux uses)
+static const int niceweight[NICEMAX - NICEMIN + 1] = {
+  9548, 7620, 6100, 4904, 3906, 3121, 2501, 1991, 1586, 1277,
+  1024, 820, 655, 526, 423, 335, 272, 215, 172, 137, 110,
+};
+
+//Returns the weight of a nice value
+int niceWeight(int nice)
+{
+  return niceweight[nice - NICEMIN];
+}
+
+//Returns the queue for a priority level
+static struct pqueue *levelQueue(int priority)
+{
+  if (priority == 0)
+    return &q0;
+  if (priority == 1)
+    return &q1;
+  return &q2;
+}
+
+//Moves process to a new priority level, with a fresh allotment
+static void
+changeQueue(struct pqueue *from, struct pqueue *to, struct proc *p)
+{
+  deleteQueue(from, p);
+  addQueue(to, p);
+  p->Ticks = 0;
+  p->allotused = 0;
+}
+
+//Removes process from specified priority queue, if it is there
+void deleteQueue(struct pqueue *pq, struct proc *p)
+{
+  int i;
+  for(i = 0; i < pq->end; i++){
+    if (pq->queue[i] == p)
+    {
+      break;
+    }
+  }
+  if (i == pq->end)
+    return;
+
+  for (int j = i; j < pq->end - 1; j++)
+  {
+    pq->queue[j] = pq->queue[j + 1];
+  }
+  pq->end--;
+  pq->numOfProc--;
+}
+
+//Downgrades process to a lower priority queue
+void degrade(struct pqueue *pq, struct proc *p)
+{
+  if (pq->priority == 0)
+  {
+    changeQueue(&q0, p->top == 2 ? &q2 : &q1, p);
+  }
+
+  else if (pq->priority == 1)
+  {
+    changeQueue(&q1, &q2, p);
+  }
+}
+
+//Returns highest priority RUNNABLE process that may run on
+//this CPU, preferring the first one that would rather run
+//here over the first one that merely can
+struct proc *returnProc(void)
+{
+  struct pqueue *pq = returnQueue();
+  int best = -1;
+
+  if (pq->numOfProc == 0)
+  {
+    return 0;
+  }
+
+  for (int i = 0; i < pq->end; i++)
+  {
+    if (runnableHere(pq->queue[i]))
+    {
+      if (best < 0)
+        best = i;
+      if (cpuPreference(pq->queue[i]) > 0)
+      {
+        best = i;
+        break;
+      }
+    }
+  }
+
+  if (best >= 0)
+  {
+    struct proc *p = pq->queue[best];
+
+    if (best != 0)
+    {
+      //Swap with first
+      struct proc *temp = pq->queue[0];
+      pq->queue[best] = temp;
+      pq->queue[0] = p;
+    }
+    return p;
+  }
+
+  return 0;
+}
+
+//Moves process from Q2 to Q0, or to its top level if lower
+void boost(struct proc *p)
+{
+  changeQueue(&q2, levelQueue(p->top), p);
+}
+
+//Moves process down to its top level if it is above it,
+//after its top level has been set
+void capLevel(struct proc *p)
+{
+  if (p->priority < p->top)
+    changeQueue(levelQueue(p->priority), levelQueue(p->top), p);
+}
+
+//CPU time p may use at pq's level: the level's slice scaled
+//by p's nice weight
+static uint allotment(struct pqueue *pq, struct proc *p)
+{
+  uint a = pq->ticks * TICKUS * niceWeight(p->nice) / 1024;
+
+  return a ? a : 1;
+}
+
+//CPU time p may still use at its current level.
+//Q2 has nowhere to demote to, so it only has a slice.
+uint allotLeft(struct pqueue *pq, struct proc *p)
+{
+  uint a = allotment(pq, p);
+
+  if (pq->priority == 2)
+    return a;
+  if (p->allotused >= a)
+    return 0;
+  return a - p->allotused;
+}
+
+//Called when p comes back to the scheduler after running
+//count ticks (used microseconds) of a slice taken from pq
+//at priority queuepriority. Updates its pstat counters and
+//moves it to the queue it should run from next.
+void endSlice(struct pqueue *pq, struct proc *p, int queuepriority, int count, uint used)
+{
+  //Maintaining pstat info
+  p->ticks[queuepriority] += count;
+  p->times[p->priority] = p->times[p->priority] + 1;
+  p->allotused += used;
+
+  //Handles case where process has used its allotment and is demoted
+  if (p->state != ZOMBIE && (p->priority == 1 || p->priority == 0) && allotLeft(pq, p) == 0)
+  {
+    p->num_stat_used++;
+    degrade(pq, p);
+  } 
+
+  //Handles case where process has been scheduled BOOSTTICKS times in Q2
+  else if (p->state != ZOMBIE && p->priority == 2 && p->Ticks >= BOOSTTICKS)
+  {
+    p->num_stat_used++;
+    boost(p);
+  }
+
+  //Handles case where process gives up the CPU with allotment left
+  else if (p->state == SLEEPING)
+  {
+    p->num_stat_used++;
+    deleteQueue(pq, p);
+    addQueue(pq, p);
+  }
+}
+
+#ifndef MLFQSIM
+//The MLFQ as a scheduling class (see sched.h).  A process
+//joins at its top level with a fresh allotment, and stays
+//queued while it sleeps.
+
+static void mlfqEnqueue(struct proc *p)
+{
+  addQueue(levelQueue(p->top), p);
+  p->Ticks = 0;
+  p->allotused = 0;
+}
+
+static void mlfqDequeue(struct proc *p)
+{
+  deleteQueue(levelQueue(p->priority), p);
+}
+
+static struct proc *mlfqPickNext(uint *slice)
+{
+  struct proc *p = returnProc();
+
+  if (p)
+    *slice = allotLeft(levelQueue(p->priority), p);
+  return p;
+}
+
+static void mlfqTick(struct proc *p, uint run)
+{
+  p->Ticks++;
+}
+
+static void mlfqYield(struct proc *p, int count, uint used)
+{
+  endSlice(levelQueue(p->priority), p, p->priority, count, used);
+}
+
+static int mlfqPreempt(struct proc *p, struct proc *cur)
+{
+  return p->priority < cur->priority;
+}
+
+static uint mlfqThrottled(int cpu)
+{
+  return 0;
+}
+
+struct schedclass mlfqclass = {
+  "mlfq", 1 << SCHED_MLFQ,
+  mlfqEnqueue, mlfqDequeue, mlfqPickNext, mlfqTick, mlfqYield, mlfqPreempt,
+  mlfqThrottled,
+};
+#endif
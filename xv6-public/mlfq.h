@@ -0,0 +1,45 @@
+// MLFQ scheduling policy (mlfq.c), shared by the kernel and
+// the host-side simulator mlfqsim.  Callers supply struct proc
+// with at least state, priority, nice, top, Ticks, allotused,
+// ticks[], times[] and num_stat_used, NPROC, TICKUS, the units
+// of CPU time per tick, and cpuPreference().
+
+struct proc;
+
+struct pqueue
+{
+  struct proc *queue[NPROC];
+  int ticks;        // time slice, in timer ticks
+  int end;
+  int numOfProc;
+  int priority;
+};
+
+extern struct pqueue q0;
+extern struct pqueue q1;
+extern struct pqueue q2;
+
+// A process that has been scheduled this many times since it
+// entered q2 is boosted back to q0.
+#define BOOSTTICKS 50
+
+// Range of nice values.  Each step up cuts a process's slices
+// and allotments by about 20%.
+#define NICEMIN -10
+#define NICEMAX 10
+
+// Supplied by the caller: -1 if p may not run on this CPU,
+// 1 if it would rather run here than elsewhere, 0 otherwise.
+int cpuPreference(struct proc *p);
+
+int niceWeight(int nice);
+void initQueues(void);
+struct pqueue *returnQueue(void);
+struct proc *returnProc(void);
+void addQueue(struct pqueue *pq, struct proc *p);
+void deleteQueue(struct pqueue *pq, struct proc *p);
+void degrade(struct pqueue *pq, struct proc *p);
+void boost(struct proc *p);
+void capLevel(struct proc *p);
+uint allotLeft(struct pqueue *pq, struct proc *p);
+void endSlice(struct pqueue *pq, struct proc *p, int queuepriority, int count, uint used);
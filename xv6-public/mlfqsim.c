@@ -0,0 +1,406 @@
+// Host-side MLFQ simulator.  Replays a workload of CPU bursts
+// and I/O waits through the kernel's scheduling policy (mlfq.c,
+// built with -DMLFQSIM) on one simulated CPU, one timer tick at
+// a time, and reports turnaround, response time, time spent
+// waiting in q2 and fairness.
+//
+// usage: mlfqsim [-v] [-n nproc] [-s seed] [tracefile]
+//
+// A trace has one process per line:
+//
+//   name arrival burst...
+//
+// where the bursts alternate CPU time and I/O wait, in ticks,
+// starting and ending with CPU time.  C/I*N stands for N CPU
+// bursts of C ticks separated by I/O waits of I ticks.  Lines
+// starting with # are comments.  Without a trace, mlfqsim makes
+// up nproc (default 1000) CPU-bound, I/O-bound and mixed
+// processes.
+//
+// mlfq.c scans its queues, sleepers included, on every pick,
+// as it does in the kernel, so a run takes time quadratic in
+// the number of processes: about a second for 5000.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mlfqsim.h"
+
+#define MAXBURST 100000  // bursts per process
+
+struct proc *procs;
+int nproc;
+int verbose;
+
+// Processes sleeping in I/O, as a heap ordered by wake time.
+struct proc **sleepers;
+int nsleep;
+
+int now;                 // current tick
+int live;                // processes admitted and not exited
+int idle;                // ticks with nothing to run
+
+static void
+die(char *msg)
+{
+  fprintf(stderr, "mlfqsim: %s\n", msg);
+  exit(1);
+}
+
+static void*
+xmalloc(size_t n)
+{
+  void *p;
+
+  if((p = malloc(n)) == 0)
+    die("out of memory");
+  return p;
+}
+
+static void
+sleeppush(struct proc *p)
+{
+  struct proc *t;
+  int i;
+
+  i = nsleep++;
+  sleepers[i] = p;
+  while(i > 0 && sleepers[(i-1)/2]->wake > sleepers[i]->wake){
+    t = sleepers[i];
+    sleepers[i] = sleepers[(i-1)/2];
+    sleepers[(i-1)/2] = t;
+    i = (i-1)/2;
+  }
+}
+
+static struct proc*
+sleeppop(void)
+{
+  struct proc *p, *t;
+  int i, c;
+
+  p = sleepers[0];
+  sleepers[0] = sleepers[--nsleep];
+  for(i = 0; (c = 2*i+1) < nsleep; i = c){
+    if(c+1 < nsleep && sleepers[c+1]->wake < sleepers[c]->wake)
+      c++;
+    if(sleepers[i]->wake <= sleepers[c]->wake)
+      break;
+    t = sleepers[i];
+    sleepers[i] = sleepers[c];
+    sleepers[c] = t;
+  }
+  return p;
+}
+
+// One CPU, so every process may run on it.
+int
+cpuPreference(struct proc *p)
+{
+  return 0;
+}
+
+static struct pqueue*
+queueof(struct proc *p)
+{
+  if(p->priority == 0)
+    return &q0;
+  if(p->priority == 1)
+    return &q1;
+  return &q2;
+}
+
+static int
+byarrival(const void *a, const void *b)
+{
+  return ((struct proc*)a)->arrival - ((struct proc*)b)->arrival;
+}
+
+static void
+addburst(struct proc *p, int ticks)
+{
+  if(p->nburst == MAXBURST)
+    die("too many bursts");
+  p->burst = realloc(p->burst, (p->nburst+1) * sizeof(int));
+  if(p->burst == 0)
+    die("out of memory");
+  p->burst[p->nburst++] = ticks;
+}
+
+// Append the bursts in trace token s to p.
+static void
+addbursts(struct proc *p, char *s)
+{
+  int c, i, n;
+
+  if(sscanf(s, "%d/%d*%d", &c, &i, &n) == 3 && c >= 0 && i >= 0){
+    while(n-- > 0){
+      addburst(p, c);
+      if(n > 0)
+        addburst(p, i);
+    }
+    return;
+  }
+  if(strchr(s, '/') || sscanf(s, "%d", &c) != 1 || c < 0)
+    die("bad burst in trace");
+  addburst(p, c);
+}
+
+static void
+readtrace(char *file)
+{
+  char line[1024], *tok;
+  struct proc *p;
+  FILE *f;
+  int max;
+
+  if((f = fopen(file, "r")) == 0)
+    die("cannot open trace");
+  max = 0;
+  while(fgets(line, sizeof(line), f)){
+    if((tok = strtok(line, " \t\n")) == 0 || tok[0] == '#')
+      continue;
+    if(nproc == max){
+      max = max ? 2*max : 64;
+      procs = realloc(procs, max * sizeof(*procs));
+      if(procs == 0)
+        die("out of memory");
+    }
+    p = &procs[nproc++];
+    memset(p, 0, sizeof(*p));
+    strncpy(p->name, tok, sizeof(p->name)-1);
+    if((tok = strtok(0, " \t\n")) == 0)
+      die("trace line has no arrival time");
+    p->arrival = atoi(tok);
+    while((tok = strtok(0, " \t\n")) != 0)
+      addbursts(p, tok);
+    if(p->nburst % 2 == 0)
+      die("trace line must end with a CPU burst");
+  }
+  fclose(f);
+}
+
+// Make up n processes arriving over the first n ticks: a
+// third CPU-bound, a third I/O-bound, a third in between.
+static void
+maketrace(int n)
+{
+  struct proc *p;
+  char tok[64];
+  int i;
+
+  procs = xmalloc(n * sizeof(*procs));
+  memset(procs, 0, n * sizeof(*procs));
+  for(i = 0; i < n; i++){
+    p = &procs[nproc++];
+    p->arrival = rand() % n;
+    switch(i % 3){
+    case 0:
+      snprintf(p->name, sizeof(p->name), "cpu%d", i);
+      snprintf(tok, sizeof(tok), "%d", 20 + rand() % 200);
+      break;
+    case 1:
+      snprintf(p->name, sizeof(p->name), "io%d", i);
+      snprintf(tok, sizeof(tok), "1/%d*%d", 2 + rand() % 20, 5 + rand() % 20);
+      break;
+    default:
+      snprintf(p->name, sizeof(p->name), "mix%d", i);
+      snprintf(tok, sizeof(tok), "%d/%d*%d", 2 + rand() % 10, 2 + rand() % 10,
+               2 + rand() % 10);
+      break;
+    }
+    addbursts(p, tok);
+  }
+}
+
+// Bring in processes that have arrived or finished their I/O
+// by now.  next is the first process not yet admitted.
+// Returns the highest priority (lowest level) among them, or
+// 3 if there were none.
+static int
+events(int *next)
+{
+  struct proc *p;
+  int top;
+
+  top = 3;
+
+  while(*next < nproc && procs[*next].arrival <= now){
+    p = &procs[(*next)++];
+    if(live == NPROC)
+      die("too many live processes; raise NPROC in mlfqsim.h");
+    live++;
+    p->pid = *next;
+    p->firstrun = -1;
+    p->left = p->burst[0];
+    p->state = RUNNABLE;
+    p->readyat = now;
+    addQueue(&q0, p);
+    top = 0;
+  }
+  while(nsleep > 0 && sleepers[0]->wake <= now){
+    p = sleeppop();
+    p->state = RUNNABLE;
+    p->readyat = now;
+    if(p->priority < top)
+      top = p->priority;
+  }
+  return top;
+}
+
+// Run p for one tick.
+static void
+tick(struct proc *p)
+{
+  now++;
+  p->Ticks++;
+  p->cputime++;
+  if(p->left > 0)
+    p->left--;
+  if(p->left > 0)
+    return;
+  if(p->cur == p->nburst - 1){
+    p->state = ZOMBIE;
+    p->finish = now;
+    return;
+  }
+  p->state = SLEEPING;
+  p->wake = now + p->burst[p->cur+1];
+  p->cur += 2;
+  p->left = p->burst[p->cur];
+  sleeppush(p);
+}
+
+static void
+simulate(void)
+{
+  struct pqueue *pq;
+  struct proc *p;
+  int next, count, queuepriority;
+  uint left;
+
+  initQueues();
+  sleepers = xmalloc(nproc * sizeof(*sleepers));
+  next = 0;
+  while(next < nproc || live > 0){
+    events(&next);
+    if((p = returnProc()) == 0){
+      // Nothing to run: skip ahead to the next event.
+      int t = next < nproc ? procs[next].arrival : -1;
+      if(nsleep > 0 && (t < 0 || sleepers[0]->wake < t))
+        t = sleepers[0]->wake;
+      idle += t - now;
+      now = t;
+      continue;
+    }
+    pq = returnQueue();
+    queuepriority = p->priority;
+    if(p->firstrun < 0)
+      p->firstrun = now;
+    if(p->priority == 2)
+      p->q2wait += now - p->readyat;
+
+    // As in scheduler(): run up to a slice, one tick at a time,
+    // ending it early if a process of higher priority wakes
+    // (preempt() in proc.c).
+    left = allotLeft(pq, p);
+    for(count = 0; p->state == RUNNABLE && count < left; ){
+      tick(p);
+      count++;
+      if(events(&next) < p->priority)
+        break;
+    }
+
+    endSlice(pq, p, queuepriority, count, count);
+    if(p->state == ZOMBIE){
+      deleteQueue(queueof(p), p);
+      live--;
+    } else if(p->state == RUNNABLE)
+      p->readyat = now;
+  }
+}
+
+static void
+report(double ms)
+{
+  struct proc *p;
+  double tat, resp, wait, x, sx, sxx;
+  int maxtat, maxresp, maxwait, t;
+  long times[3], ticks[3];
+  int i;
+
+  tat = resp = wait = sx = sxx = 0;
+  maxtat = maxresp = maxwait = 0;
+  memset(times, 0, sizeof(times));
+  memset(ticks, 0, sizeof(ticks));
+  for(p = procs; p < &procs[nproc]; p++){
+    t = p->finish - p->arrival;
+    tat += t;
+    if(t > maxtat)
+      maxtat = t;
+    resp += p->firstrun - p->arrival;
+    if(p->firstrun - p->arrival > maxresp)
+      maxresp = p->firstrun - p->arrival;
+    wait += p->q2wait;
+    if(p->q2wait > maxwait)
+      maxwait = p->q2wait;
+    // Fairness: share of its lifetime each process got the CPU.
+    x = t > 0 ? (double)p->cputime / t : 1;
+    sx += x;
+    sxx += x * x;
+    for(i = 0; i < 3; i++){
+      times[i] += p->times[i];
+      ticks[i] += p->ticks[i];
+    }
+    if(verbose)
+      printf("%-16s pid %5d arrive %7d cpu %6d turnaround %7d response %6d "
+             "q2wait %7d times {%d, %d, %d}\n",
+             p->name, p->pid, p->arrival, p->cputime, t,
+             p->firstrun - p->arrival, p->q2wait,
+             p->times[0], p->times[1], p->times[2]);
+  }
+
+  printf("%d processes, %d ticks (%d idle), simulated in %.1f ms\n",
+         nproc, now, idle, ms);
+  printf("turnaround  avg %9.1f  max %7d\n", tat / nproc, maxtat);
+  printf("response    avg %9.1f  max %7d\n", resp / nproc, maxresp);
+  printf("q2 wait     avg %9.1f  max %7d\n", wait / nproc, maxwait);
+  printf("fairness    %.3f (Jain index of cpu time / turnaround)\n",
+         sx * sx / (nproc * sxx));
+  printf("scheduled   q0 %ld  q1 %ld  q2 %ld times\n", times[0], times[1], times[2]);
+  printf("ran         q0 %ld  q1 %ld  q2 %ld ticks\n", ticks[0], ticks[1], ticks[2]);
+}
+
+int
+main(int argc, char *argv[])
+{
+  clock_t c0, c1;
+  int i, n;
+
+  n = 1000;
+  for(i = 1; i < argc && argv[i][0] == '-'; i++){
+    if(strcmp(argv[i], "-v") == 0)
+      verbose = 1;
+    else if(strcmp(argv[i], "-n") == 0 && i+1 < argc)
+      n = atoi(argv[++i]);
+    else if(strcmp(argv[i], "-s") == 0 && i+1 < argc)
+      srand(atoi(argv[++i]));
+    else
+      die("usage: mlfqsim [-v] [-n nproc] [-s seed] [tracefile]");
+  }
+  if(i < argc)
+    readtrace(argv[i]);
+  else
+    maketrace(n);
+  if(nproc == 0)
+    die("no processes");
+  qsort(procs, nproc, sizeof(*procs), byarrival);
+
+  c0 = clock();
+  simulate();
+  c1 = clock();
+  report((c1 - c0) * 1000.0 / CLOCKS_PER_SEC);
+  return 0;
+}
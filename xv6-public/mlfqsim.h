@@ -0,0 +1,47 @@
+// Host-side stand-ins for the kernel definitions that mlfq.c
+// uses, for building it into the mlfqsim simulator.
+
+#define NPROC 8192       // most processes alive at once
+#define TICKUS 1         // the simulator counts CPU time in ticks
+
+typedef unsigned int uint;
+
+enum procstate
+{
+  UNUSED,
+  EMBRYO,
+  SLEEPING,
+  RUNNABLE,
+  RUNNING,
+  ZOMBIE
+};
+
+struct proc
+{
+  enum procstate state;
+  int pid;
+  int priority;
+  int nice;
+  int top;
+  int ticks[3];
+  int times[3];
+  int num_stat_used;
+  int Ticks;
+  uint allotused;
+
+  // Simulator only.
+  char name[16];
+  int *burst;       // CPU burst, I/O wait, CPU burst, ... in ticks
+  int nburst;       // always odd: starts and ends with a CPU burst
+  int cur;          // index of the current CPU burst
+  int left;         // ticks left in it
+  int arrival;      // tick the process was created
+  int firstrun;     // tick it first ran, or -1
+  int finish;       // tick it exited
+  int wake;         // tick its I/O wait ends, while SLEEPING
+  int readyat;      // tick it last became RUNNABLE
+  int q2wait;       // ticks RUNNABLE but not running in q2
+  int cputime;      // ticks run
+};
+
+#include "mlfq.h"
@@ -0,0 +1,9 @@
+// mmap() protection and flag bits.
+#define PROT_READ    0x1
+#define PROT_WRITE   0x2
+
+#define MAP_SHARED   0x1  // file: map the page cache pages themselves
+#define MAP_PRIVATE  0x2  // file: map a private copy of the file pages
+#define MAP_ANON     0x4  // zero-filled memory, not backed by a file
+
+#define MAP_FAILED   ((void*)-1)
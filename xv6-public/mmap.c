@@ -0,0 +1,402 @@
+// Memory-mapped files and anonymous memory.
+//
+// Each address space has a small table of mappings (vm->vmas),
+// placed top-down below KERNBASE so they stay clear of the heap
+// that sbrk() grows upward from vm->sz. mmap() only records the
+// mapping; pages are filled in on demand by mmapfault(), which
+// trap() calls on a user page fault.
+//
+// Threads (see clone() in proc.c) share the address space, and
+// change its mappings or their page table entries holding
+// vm->mlock.  munmap() first waits for the other threads to
+// leave the kernel's view of their user memory (vmshrink()),
+// since a system call might be using the pages it removes.
+//
+// * MAP_SHARED file mappings map the page cache page itself
+//   (see pcache.c), pinned by a reference for as long as it is
+//   mapped, so every process mapping the file sees one copy.
+//   Writable shared pages that the hardware marked dirty are
+//   written back to the file when they are unmapped.
+// * MAP_PRIVATE file mappings and MAP_ANON mappings get a page
+//   of their own, filled from the file or with zeros.
+//
+// Mapped pages are unmapped explicitly (munmap, or munmapall
+// from exit and exec) before the page table is freed, because
+// freevm() would otherwise kfree the pinned page cache pages.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "x86.h"
+#include "stat.h"
+#include "proc.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "vmspace.h"
+#include "fs.h"
+#include "file.h"
+#include "mman.h"
+#include "pcache.h"
+
+// Return the mapping in vm that contains va, or 0.
+static struct vma*
+findvma(struct vmspace *vm, uint va)
+{
+  struct vma *v;
+
+  for(v = vm->vmas; v < &vm->vmas[NVMA]; v++)
+    if(v->end && va >= v->start && va < v->end)
+      return v;
+  return 0;
+}
+
+// Lowest address used by a mapping in vm, or KERNBASE.
+// growproc() must not grow the heap past it.
+uint
+mmaplow(struct vmspace *vm)
+{
+  struct vma *v;
+  uint low;
+
+  low = KERNBASE;
+  for(v = vm->vmas; v < &vm->vmas[NVMA]; v++)
+    if(v->end && v->start < low)
+      low = v->start;
+  return low;
+}
+
+// Map len bytes of f at offset off, or zero-filled memory
+// if flags has MAP_ANON, into the current process.
+// Returns the address of the mapping, or -1.
+int
+mmap(int len, int prot, int flags, struct file *f, int off)
+{
+  struct vmspace *vm = myproc()->vm;
+  struct vma *v, *free;
+  uint start, end;
+
+  if(len <= 0 || off < 0 || off % PGSIZE != 0)
+    return -1;
+  if(((flags & MAP_SHARED) != 0) == ((flags & MAP_PRIVATE) != 0))
+    return -1;
+  if(!(flags & MAP_ANON)){
+    if(f == 0 || f->type != FD_INODE || !f->readable)
+      return -1;
+    if((flags & MAP_SHARED) && (prot & PROT_WRITE) && !f->writable)
+      return -1;
+    ilock(f->ip);
+    if(f->ip->type != T_FILE){
+      iunlock(f->ip);
+      return -1;
+    }
+    iunlock(f->ip);
+  }
+
+  acquiresleep(&vm->mlock);
+  free = 0;
+  for(v = vm->vmas; v < &vm->vmas[NVMA]; v++)
+    if(v->end == 0){
+      free = v;
+      break;
+    }
+  if(free == 0){
+    releasesleep(&vm->mlock);
+    return -1;
+  }
+
+  // Find the highest hole below KERNBASE that fits.
+  len = PGROUNDUP(len);
+  end = KERNBASE;
+again:
+  if(end < len || end - len < PGROUNDUP(vm->sz)){
+    releasesleep(&vm->mlock);
+    return -1;
+  }
+  start = end - len;
+  for(v = vm->vmas; v < &vm->vmas[NVMA]; v++){
+    if(v->end && v->start < end && start < v->end){
+      end = v->start;
+      goto again;
+    }
+  }
+
+  free->start = start;
+  free->end = end;
+  free->prot = prot;
+  free->flags = flags;
+  free->off = off;
+  free->f = (flags & MAP_ANON) ? 0 : filedup(f);
+  releasesleep(&vm->mlock);
+  return start;
+}
+
+// Unmap the pages of v in [a, b) from vm's page table,
+// writing back dirty pages of a writable shared mapping.
+static void
+vmaunmap(struct vmspace *vm, struct vma *v, uint a, uint b)
+{
+  struct page *pg;
+  pte_t *pte;
+  uint va, pa, foff;
+
+  for(va = a; va < b; va += PGSIZE){
+    if((pte = walkpgdir(vm->pgdir, (char*)va, 0)) == 0 || (*pte & PTE_P) == 0)
+      continue;
+    pa = PTE_ADDR(*pte);
+    foff = v->off + (va - v->start);
+    if(v->f && (v->flags & MAP_SHARED)){
+      if((v->prot & PROT_WRITE) && (*pte & PTE_D))
+        filewriteback(v->f, P2V(pa), foff, PGSIZE);
+      // Drop the lookup's reference and the mapping's.
+      if((pg = pget(v->f->ip->dev, v->f->ip->inum, foff/PGSIZE, 0)) == 0)
+        panic("vmaunmap");
+      pput(pg);
+      pput(pg);
+    } else
+      kfree(P2V(pa));
+    *pte = 0;
+  }
+  if(vm == myproc()->vm){
+    lcr3(V2P(vm->pgdir));  // flush the stale TLB entries
+    tlbshootdown(vm);
+  }
+}
+
+// Remove the pages [addr, addr+len) from the mapping that
+// contains them.  Removing pages from the middle of a mapping
+// splits it in two, which needs a free slot in vm->vmas.
+int
+munmap(uint addr, int len)
+{
+  struct vmspace *vm = myproc()->vm;
+  struct vma *v, *nv;
+  uint end;
+
+  if(len <= 0 || addr % PGSIZE != 0 || addr + len < addr)
+    return -1;
+  end = PGROUNDUP(addr + len);
+  vmshrink(vm);
+  acquiresleep(&vm->mlock);
+  if((v = findvma(vm, addr)) == 0 || end > v->end)
+    goto bad;
+  nv = 0;
+  if(addr > v->start && end < v->end){
+    for(nv = vm->vmas; nv < &vm->vmas[NVMA]; nv++)
+      if(nv->end == 0)
+        break;
+    if(nv == &vm->vmas[NVMA])
+      goto bad;
+  }
+
+  vmaunmap(vm, v, addr, end);
+  if(nv){
+    // Keep [v->start, addr) in v and [end, v->end) in nv.
+    *nv = *v;
+    nv->off += end - v->start;
+    nv->start = end;
+    if(nv->f)
+      filedup(nv->f);
+    v->end = addr;
+  } else if(addr > v->start){
+    v->end = addr;
+  } else if(end < v->end){
+    v->off += end - v->start;
+    v->start = end;
+  } else {
+    if(v->f)
+      fileclose(v->f);
+    memset(v, 0, sizeof(*v));
+  }
+  releasesleep(&vm->mlock);
+  vmshrinkdone(vm);
+  return 0;
+
+bad:
+  releasesleep(&vm->mlock);
+  vmshrinkdone(vm);
+  return -1;
+}
+
+// Remove all of vm's mappings.  Called by exit() and exec()
+// once no other thread uses vm.
+void
+munmapall(struct vmspace *vm)
+{
+  struct vma *v;
+
+  for(v = vm->vmas; v < &vm->vmas[NVMA]; v++){
+    if(v->end == 0)
+      continue;
+    vmaunmap(vm, v, v->start, v->end);
+    if(v->f)
+      fileclose(v->f);
+    memset(v, 0, sizeof(*v));
+  }
+}
+
+// Fill in the page at a in mapping v of vm.
+static int
+vmafault(struct vmspace *vm, struct vma *v, uint a)
+{
+  struct page *pg;
+  struct inode *ip;
+  char *mem;
+  uint foff;
+  int perm;
+
+  perm = PTE_U;
+  if(v->prot & PROT_WRITE)
+    perm |= PTE_W;
+  foff = v->off + (a - v->start);
+
+  pg = 0;
+  if(v->f && (v->flags & MAP_SHARED)){
+    ip = v->f->ip;
+    ilock(ip);
+    pg = igetpage(ip, foff/PGSIZE);
+    iunlock(ip);
+    if(pg == 0)
+      return -1;
+    mem = pg->data;
+  } else {
+    if((mem = kalloc()) == 0)
+      return -1;
+    memset(mem, 0, PGSIZE);
+    if(v->f){
+      ip = v->f->ip;
+      ilock(ip);
+      readi(ip, mem, foff, PGSIZE);
+      iunlock(ip);
+    }
+  }
+
+  if(mappages(vm->pgdir, (char*)a, PGSIZE, V2P(mem), perm) < 0){
+    if(pg)
+      pput(pg);
+    else
+      kfree(mem);
+    return -1;
+  }
+  return 0;
+}
+
+// Handle a page fault at va in the current process.
+// Returns 0 if va is in a mapping and the page is now
+// present, -1 if the process touched memory it should not.
+int
+mmapfault(uint va)
+{
+  struct vmspace *vm = myproc()->vm;
+  struct vma *v;
+  pte_t *pte;
+  uint a;
+  int r;
+
+  a = PGROUNDDOWN(va);
+  if((pte = walkpgdir(vm->pgdir, (char*)a, 0)) != 0 && (*pte & PTE_P))
+    return -1;  // present, so this was a protection fault
+  acquiresleep(&vm->mlock);
+  if((pte = walkpgdir(vm->pgdir, (char*)a, 0)) != 0 && (*pte & PTE_P))
+    r = 0;      // another thread faulted it in first
+  else if((v = findvma(vm, va)) == 0)
+    r = -1;
+  else
+    r = vmafault(vm, v, a);
+  releasesleep(&vm->mlock);
+  return r;
+}
+
+// Check that [va, va+size) lies inside one mapping of the
+// current process, and fault in its pages so that the kernel
+// can use the range without faulting.  Used by argptr(); the
+// system call's hold on the address space (vmuse()) keeps the
+// mapping from going away afterwards.
+int
+mmapcheck(uint va, int size)
+{
+  struct vmspace *vm = myproc()->vm;
+  struct vma *v;
+  pte_t *pte;
+  uint a, end;
+
+  acquiresleep(&vm->mlock);
+  v = findvma(vm, va);
+  end = v ? v->end : 0;
+  releasesleep(&vm->mlock);
+  if(size < 0 || v == 0 || va + size > end)
+    return -1;
+  for(a = PGROUNDDOWN(va); a < va + size; a += PGSIZE){
+    pte = walkpgdir(vm->pgdir, (char*)a, 0);
+    if((pte == 0 || (*pte & PTE_P) == 0) && mmapfault(a) < 0)
+      return -1;
+  }
+  return 0;
+}
+
+// End of the mapping of the current process that contains
+// va, or 0 if none does.  Used by fetchstr(), which does not
+// know how long the string it checks is.
+uint
+mmapend(uint va)
+{
+  struct vmspace *vm = myproc()->vm;
+  struct vma *v;
+  uint end;
+
+  acquiresleep(&vm->mlock);
+  v = findvma(vm, va);
+  end = v ? v->end : 0;
+  releasesleep(&vm->mlock);
+  return end;
+}
+
+// Give nvm, a forked child's address space, a copy of vm's
+// mappings.  Shared file pages stay shared; private and
+// anonymous pages are copied.  Caller holds vm->mlock.
+int
+mmapfork(struct vmspace *vm, struct vmspace *nvm)
+{
+  struct vma *v, *nv;
+  struct page *pg;
+  pte_t *pte;
+  char *mem;
+  uint va, foff;
+
+  for(v = vm->vmas, nv = nvm->vmas; v < &vm->vmas[NVMA]; v++, nv++){
+    if(v->end == 0)
+      continue;
+    *nv = *v;
+    if(v->f)
+      filedup(v->f);
+    for(va = v->start; va < v->end; va += PGSIZE){
+      if((pte = walkpgdir(vm->pgdir, (char*)va, 0)) == 0 || (*pte & PTE_P) == 0)
+        continue;
+      foff = v->off + (va - v->start);
+      pg = 0;
+      if(v->f && (v->flags & MAP_SHARED)){
+        if((pg = pget(v->f->ip->dev, v->f->ip->inum, foff/PGSIZE, 0)) == 0)
+          panic("mmapfork");
+        mem = pg->data;
+      } else {
+        if((mem = kalloc()) == 0)
+          goto bad;
+        memmove(mem, P2V(PTE_ADDR(*pte)), PGSIZE);
+      }
+      if(mappages(nvm->pgdir, (char*)va, PGSIZE, V2P(mem),
+                  PTE_FLAGS(*pte) & (PTE_W|PTE_U)) < 0){
+        if(pg)
+          pput(pg);
+        else
+          kfree(mem);
+        goto bad;
+      }
+    }
+  }
+  return 0;
+
+bad:
+  munmapall(nvm);
+  return -1;
+}
@@ -0,0 +1,139 @@
+// Compare wc and grep reading a file with read() against
+// the same programs mapping it with mmap() (-m), check that a
+// shared mapping writes through to the file, and that part of
+// a mapping can be unmapped.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "mman.h"
+
+#define NLINES 2000
+#define ROUNDS 20
+
+void
+run(char **argv)
+{
+  int i, pid, fd, t0, t1;
+
+  t0 = uptime();
+  for(i = 0; i < ROUNDS; i++){
+    pid = fork();
+    if(pid < 0){
+      printf(1, "mmapbench: fork failed\n");
+      exit();
+    }
+    if(pid == 0){
+      close(1);
+      if((fd = open("mbout", O_CREATE | O_RDWR)) != 1){
+        printf(2, "mmapbench: open mbout failed\n");
+        exit();
+      }
+      exec(argv[0], argv);
+      printf(2, "mmapbench: exec %s failed\n", argv[0]);
+      exit();
+    }
+    wait();
+  }
+  t1 = uptime();
+  printf(1, "%s %s x%d: %d ticks\n", argv[0], argv[1], ROUNDS, t1 - t0);
+}
+
+void
+sharedtest(void)
+{
+  int fd;
+  char *p, c;
+
+  if((fd = open("mbfile", O_RDWR)) < 0){
+    printf(1, "mmapbench: open mbfile failed\n");
+    exit();
+  }
+  p = mmap(0, 4096, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  if(p == MAP_FAILED){
+    printf(1, "mmapbench: mmap failed\n");
+    exit();
+  }
+  p[0] = 'X';
+  if(munmap(p, 4096) < 0){
+    printf(1, "mmapbench: munmap failed\n");
+    exit();
+  }
+  if(read(fd, &c, 1) != 1 || c != 'X'){
+    printf(1, "mmapbench: shared write not seen by read\n");
+    exit();
+  }
+  close(fd);
+}
+
+// Unmap the middle page of three, then the others.
+void
+splittest(void)
+{
+  char *p;
+
+  p = mmap(0, 3*4096, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANON, -1, 0);
+  if(p == MAP_FAILED){
+    printf(1, "mmapbench: mmap failed\n");
+    exit();
+  }
+  p[0] = 'a';
+  p[2*4096] = 'c';
+  if(munmap(p + 4096, 4096) < 0){
+    printf(1, "mmapbench: munmap of middle page failed\n");
+    exit();
+  }
+  if(p[0] != 'a' || p[2*4096] != 'c'){
+    printf(1, "mmapbench: split mapping lost its contents\n");
+    exit();
+  }
+  if(munmap(p + 2*4096, 4096) < 0 || munmap(p, 4096) < 0){
+    printf(1, "mmapbench: munmap of split pieces failed\n");
+    exit();
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  char line[40];
+  char *wcr[] = { "wc", "mbfile", 0 };
+  char *wcm[] = { "wc", "-m", "mbfile", 0 };
+  char *grepr[] = { "grep", "line.*7$", "mbfile", 0 };
+  char *grepm[] = { "grep", "-m", "line.*7$", "mbfile", 0 };
+  int fd, i, n;
+
+  printf(1, "mmapbench starting\n");
+
+  if((fd = open("mbfile", O_CREATE | O_RDWR)) < 0){
+    printf(1, "mmapbench: create mbfile failed\n");
+    exit();
+  }
+  strcpy(line, "this is text line number ");
+  n = strlen(line);
+  for(i = 0; i < NLINES; i++){
+    line[n] = '0' + i / 1000 % 10;
+    line[n+1] = '0' + i / 100 % 10;
+    line[n+2] = '0' + i / 10 % 10;
+    line[n+3] = '0' + i % 10;
+    line[n+4] = '\n';
+    if(write(fd, line, n+5) != n+5){
+      printf(1, "mmapbench: write mbfile failed\n");
+      exit();
+    }
+  }
+  close(fd);
+
+  run(wcr);
+  run(wcm);
+  run(grepr);
+  run(grepm);
+  sharedtest();
+  splittest();
+
+  unlink("mbout");
+  unlink("mbfile");
+  printf(1, "mmapbench ok\n");
+  exit();
+}
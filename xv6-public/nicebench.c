@@ -0,0 +1,66 @@
+// Competing CPU hogs, as in test2, with different nice values,
+// plus a batch hog capped at q2.  Prints the share of the CPU
+// each one got next to the share its nice weight calls for.
+// Run with make CPUS=1 so that the hogs share one CPU.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "pstat.h"
+
+#define DURATION 500     // ticks to let the hogs run
+
+struct hog {
+  int nice;
+  int top;
+  int weight;            // from niceweight[] in mlfq.c
+} hogs[] = {
+  { -5, 0, 3121 },
+  {  0, 0, 1024 },
+  {  5, 0,  335 },
+  {  5, 2,  335 },
+};
+
+#define NHOGS (sizeof(hogs) / sizeof(hogs[0]))
+
+static struct pstat ps;
+
+int
+main(int argc, char *argv[])
+{
+  int pids[NHOGS], runtime[NHOGS];
+  int i, tot, wtot;
+
+  printf(1, "nicebench starting\n");
+  for(i = 0; i < NHOGS; i++){
+    if((pids[i] = fork()) == 0){
+      if(nice(0, hogs[i].nice, hogs[i].top) < 0){
+        printf(1, "nicebench: nice failed\n");
+        exit();
+      }
+      for(;;)
+        ;
+    }
+  }
+  sleep(DURATION);
+
+  tot = wtot = 0;
+  for(i = 0; i < NHOGS; i++){
+    if(getpstat(pids[i], &ps) < 0){
+      printf(1, "nicebench: getpstat %d failed\n", pids[i]);
+      runtime[i] = 0;
+    } else
+      runtime[i] = ps.runtime[0] + ps.runtime[1] + ps.runtime[2];
+    tot += runtime[i] / 1000;
+    wtot += hogs[i].weight;
+  }
+  for(i = 0; i < NHOGS; i++){
+    printf(1, "nice %d, top q%d: ran %d ms, %d%% of the CPU (weight %d%%)\n",
+           hogs[i].nice, hogs[i].top, runtime[i] / 1000,
+           tot ? runtime[i] / 10 / tot : 0, hogs[i].weight * 100 / wtot);
+    kill(pids[i]);
+    wait();
+  }
+  printf(1, "nicebench ok\n");
+  exit();
+}
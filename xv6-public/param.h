@@ -2,13 +2,24 @@
 #define KSTACKSIZE 4096  // size of per-process kernel stack
 #define NCPU          8  // maximum number of CPUs
 #define NOFILE       16  // open files per process
-#define NFILE       100  // open files per system
-#define NINODE       50  // maximum number of active i-nodes
+#define NVMA         16  // memory mappings per process
+#define PIPESIZE   4096  // bytes in a pipe ring; power of 2, <= PGSIZE
+#define NINODE       50  // minimum limit on cached i-nodes
+#define NINODEMAX  1000  // maximum limit on cached i-nodes
+#define NIHASH      127  // hash buckets in the i-node cache
+#define NPCACHE     512  // pages in the file page cache
+#define NPHASH      251  // hash buckets in the file page cache
 #define NDEV         10  // maximum major device number
+#define NLOCKCLASS   64  // lock names tracked by lockstat()
+#define SLEEPSPIN 20000  // cycles acquiresleep() spins on a running holder
+#define TICKUS    10000  // microseconds per timer tick
 #define ROOTDEV       1  // device number of file system root disk
 #define MAXARG       32  // max exec arguments
+#define MAXPATH     128  // maximum file path name
 #define MAXOPBLOCKS  10  // max # of blocks any FS op writes
 #define LOGSIZE      (MAXOPBLOCKS*3)  // max data blocks in on-disk log
 #define NBUF         (MAXOPBLOCKS*3)  // size of disk block cache
-#define FSSIZE       1000  // size of file system in blocks
+#define FSSIZE       4000  // size of file system in blocks
+#define NDCACHE    1024  // entries in the directory name cache
+#define NDCHASH     251  // hash buckets in the directory name cache
 
@@ -0,0 +1,185 @@
+// File page cache.
+//
+// The page cache holds whole 4096-byte pages of regular file
+// contents, each assembled from the 8 disk blocks that back it.
+// readi() copies straight out of a cached page, so a large read
+// costs one lookup and one memmove per page instead of a bmap(),
+// bread() and brelse() per 512-byte block.
+//
+// Pages are identified by (dev, inum, pgno), where pgno is the
+// file offset divided by PGSIZE. Only regular files are cached:
+// directory blocks are edited in place in the buffer cache.
+//
+// Interface:
+// * To get a page, call pget. If the page is not valid,
+//     the caller fills it (see igetpage in fs.c) and sets valid.
+// * When done with the page, call pput.
+// * writei() updates cached pages along with the disk blocks,
+//     and freeing an inode invalidates all of its pages.
+// * mmap() maps MAP_SHARED file pages straight from the cache;
+//     the mapping holds a reference until it is unmapped.
+//
+// pcache.lock protects the table, the hash chains, the LRU
+// list and ref. All other fields of a page belong to the inode
+// it caches and may only be used while holding that inode's
+// lock, which every caller of these functions does.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "mmu.h"
+#include "spinlock.h"
+#include "pcache.h"
+
+struct {
+  struct spinlock lock;
+  struct page page[NPCACHE];
+  struct page *hash[NPHASH];
+
+  // Linked list of all pages, through prev/next.
+  // head.next is most recently used.
+  struct page head;
+
+  uint hits;          // pget() found a valid page
+  uint misses;        // pget() returned a page that must be filled
+} pcache;
+
+#define PHASH(dev, inum, pgno) (((dev) * 31 + (inum) * 17 + (pgno)) % NPHASH)
+
+void
+pcacheinit(void)
+{
+  struct page *pg;
+
+  initlock(&pcache.lock, "pcache");
+
+  pcache.head.prev = &pcache.head;
+  pcache.head.next = &pcache.head;
+  for(pg = pcache.page; pg < pcache.page+NPCACHE; pg++){
+    pg->next = pcache.head.next;
+    pg->prev = &pcache.head;
+    pcache.head.next->prev = pg;
+    pcache.head.next = pg;
+  }
+}
+
+// Remove pg from its hash chain.
+// Caller must hold pcache.lock.
+static void
+phashremove(struct page *pg)
+{
+  struct page **pp;
+
+  for(pp = &pcache.hash[PHASH(pg->dev, pg->inum, pg->pgno)]; *pp; pp = &(*pp)->hnext){
+    if(*pp == pg){
+      *pp = pg->hnext;
+      break;
+    }
+  }
+  pg->hnext = 0;
+}
+
+// Look through the page cache for page pgno of inode
+// (dev, inum). If not found and alloc is set, recycle an
+// unused page. Returns a referenced page, which may not be
+// valid, or 0 if the page is not cached (alloc == 0) or
+// there is no page to spare.
+struct page*
+pget(uint dev, uint inum, uint pgno, int alloc)
+{
+  struct page *pg;
+  uint h;
+
+  acquire(&pcache.lock);
+
+  // Is the page already cached?
+  h = PHASH(dev, inum, pgno);
+  for(pg = pcache.hash[h]; pg; pg = pg->hnext){
+    if(pg->dev == dev && pg->inum == inum && pg->pgno == pgno){
+      pg->ref++;
+      if(alloc){
+        if(pg->valid)
+          pcache.hits++;
+        else
+          pcache.misses++;
+      }
+      release(&pcache.lock);
+      return pg;
+    }
+  }
+  if(!alloc){
+    release(&pcache.lock);
+    return 0;
+  }
+
+  // Not cached; recycle the least recently used unused page.
+  for(pg = pcache.head.prev; pg != &pcache.head; pg = pg->prev){
+    if(pg->ref == 0){
+      if(pg->data == 0 && (pg->data = kalloc()) == 0)
+        break;
+      if(pg->inum != 0)
+        phashremove(pg);
+      pg->dev = dev;
+      pg->inum = inum;
+      pg->pgno = pgno;
+      pg->valid = 0;
+      pg->ref = 1;
+      pg->hnext = pcache.hash[h];
+      pcache.hash[h] = pg;
+      pcache.misses++;
+      release(&pcache.lock);
+      return pg;
+    }
+  }
+  release(&pcache.lock);
+  return 0;
+}
+
+// Release a page.
+// Move to the head of the MRU list.
+void
+pput(struct page *pg)
+{
+  acquire(&pcache.lock);
+  if(pg->ref < 1)
+    panic("pput");
+  pg->ref--;
+  if(pg->ref == 0){
+    pg->next->prev = pg->prev;
+    pg->prev->next = pg->next;
+    pg->next = pcache.head.next;
+    pg->prev = &pcache.head;
+    pcache.head.next->prev = pg;
+    pcache.head.next = pg;
+  }
+  release(&pcache.lock);
+}
+
+// Invalidate pages first through last of inode (dev, inum).
+void
+pinval(uint dev, uint inum, uint first, uint last)
+{
+  struct page *pg;
+  uint pgno;
+
+  acquire(&pcache.lock);
+  for(pgno = first; pgno <= last; pgno++){
+    for(pg = pcache.hash[PHASH(dev, inum, pgno)]; pg; pg = pg->hnext){
+      if(pg->dev == dev && pg->inum == inum && pg->pgno == pgno){
+        pg->valid = 0;
+        break;
+      }
+    }
+  }
+  release(&pcache.lock);
+}
+
+// Report page cache hits and misses.
+void
+pcachestat(uint *hits, uint *misses)
+{
+  acquire(&pcache.lock);
+  *hits = pcache.hits;
+  *misses = pcache.misses;
+  release(&pcache.lock);
+}
@@ -0,0 +1,12 @@
+// A page of file data in the page cache.
+struct page {
+  uint dev;
+  uint inum;
+  uint pgno;          // file offset / PGSIZE
+  int valid;          // data has been read from the file
+  int ref;
+  char *data;         // PGSIZE bytes, from kalloc
+  struct page *hnext; // hash chain
+  struct page *prev;  // LRU cache list
+  struct page *next;
+};
@@ -0,0 +1,103 @@
+// Measure how much a process polling the scheduler statistics
+// slows down CPU-bound work.  getpstat() reads them without
+// taking ptable.lock, so the workers should see little change
+// with the poller running.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "pstat.h"
+
+#define NWORKERS 3
+#define DURATION 200     // ticks each round runs for
+
+static struct pstat ps;
+
+// Spin for DURATION ticks and report how many loop
+// iterations got done on fd.
+static void
+worker(int fd)
+{
+  uint n;
+  int end;
+
+  end = uptime() + DURATION;
+  for(n = 0; uptime() < end; n++)
+    ;
+  write(fd, &n, sizeof(n));
+  exit();
+}
+
+// Call getpstat() on the workers until DURATION ticks pass,
+// and report the number of calls on fd.
+static void
+poller(int fd, int *pids)
+{
+  uint n;
+  int end;
+
+  end = uptime() + DURATION;
+  for(n = 0; uptime() < end; n++){
+    if(getpstat(pids[n % NWORKERS], &ps) < 0){
+      printf(1, "pinfobench: getpstat %d failed\n", pids[n % NWORKERS]);
+      break;
+    }
+  }
+  write(fd, &n, sizeof(n));
+  exit();
+}
+
+static void
+run(int poll)
+{
+  int fds[2], pids[NWORKERS];
+  uint n, work, polls;
+  int i;
+
+  if(pipe(fds) < 0){
+    printf(1, "pinfobench: pipe failed\n");
+    exit();
+  }
+  for(i = 0; i < NWORKERS; i++){
+    if((pids[i] = fork()) == 0){
+      close(fds[0]);
+      worker(fds[1]);
+    }
+  }
+  if(poll && fork() == 0){
+    close(fds[0]);
+    poller(fds[1], pids);
+  }
+  close(fds[1]);
+
+  work = polls = 0;
+  for(i = 0; i < NWORKERS; i++){
+    if(read(fds[0], &n, sizeof(n)) != sizeof(n)){
+      printf(1, "pinfobench: short read\n");
+      exit();
+    }
+    work += n >> 10;
+  }
+  if(poll && read(fds[0], &polls, sizeof(polls)) != sizeof(polls)){
+    printf(1, "pinfobench: short read\n");
+    exit();
+  }
+  close(fds[0]);
+  for(i = 0; i < NWORKERS + poll; i++)
+    wait();
+
+  printf(1, "%s poller: %d K worker iterations", poll ? "with" : "without", work);
+  if(poll)
+    printf(1, ", %d getpstat calls", polls);
+  printf(1, "\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+  printf(1, "pinfobench starting\n");
+  run(0);
+  run(1);
+  printf(1, "pinfobench ok\n");
+  exit();
+}
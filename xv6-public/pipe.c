@@ -7,18 +7,37 @@
 #include "spinlock.h"
 #include "sleeplock.h"
 #include "file.h"
+#include "slab.h"
 
-#define PIPESIZE 512
+// Data moves through the ring in contiguous chunks.  To keep
+// wakeup() calls (each a scan of the process table) off the
+// common path, a side only wakes the other if it is asleep:
+// a writer wakes readers when the ring fills or the write is
+// done, and a reader wakes writers once at least PIPELOWAT
+// bytes are free, so a writer moves a batch per wakeup rather
+// than a byte.
+#define PIPELOWAT (PIPESIZE/2)
 
 struct pipe {
   struct spinlock lock;
-  char data[PIPESIZE];
+  char *data;     // ring of PIPESIZE bytes
   uint nread;     // number of bytes read
   uint nwrite;    // number of bytes written
   int readopen;   // read fd is still open
   int writeopen;  // write fd is still open
+  int rwait;      // a reader is sleeping on nread
+  int wwait;      // a writer is sleeping on nwrite
+  int rbusy;      // splice() is reading from the ring in place
 };
 
+static struct slab pipeslab;
+
+void
+pipeinit(void)
+{
+  slabinit(&pipeslab, "pipe", sizeof(struct pipe));
+}
+
 int
 pipealloc(struct file **f0, struct file **f1)
 {
@@ -28,12 +47,18 @@ pipealloc(struct file **f0, struct file **f1)
   *f0 = *f1 = 0;
   if((*f0 = filealloc()) == 0 || (*f1 = filealloc()) == 0)
     goto bad;
-  if((p = (struct pipe*)kalloc()) == 0)
+  if((p = slaballoc(&pipeslab)) == 0)
+    goto bad;
+  p->data = 0;
+  if((p->data = kalloc()) == 0)
     goto bad;
   p->readopen = 1;
   p->writeopen = 1;
   p->nwrite = 0;
   p->nread = 0;
+  p->rwait = 0;
+  p->wwait = 0;
+  p->rbusy = 0;
   initlock(&p->lock, "pipe");
   (*f0)->type = FD_PIPE;
   (*f0)->readable = 1;
@@ -47,8 +72,11 @@ pipealloc(struct file **f0, struct file **f1)
 
 //PAGEBREAK: 20
  bad:
-  if(p)
-    kfree((char*)p);
+  if(p){
+    if(p->data)
+      kfree(p->data);
+    slabfree(&pipeslab, p);
+  }
   if(*f0)
     fileclose(*f0);
   if(*f1)
@@ -69,7 +97,8 @@ pipeclose(struct pipe *p, int writable)
   }
   if(p->readopen == 0 && p->writeopen == 0){
     release(&p->lock);
-    kfree((char*)p);
+    kfree(p->data);
+    slabfree(&pipeslab, p);
   } else
     release(&p->lock);
 }
@@ -78,21 +107,38 @@ pipeclose(struct pipe *p, int writable)
 int
 pipewrite(struct pipe *p, char *addr, int n)
 {
-  int i;
+  int i, m;
 
   acquire(&p->lock);
-  for(i = 0; i < n; i++){
+  for(i = 0; i < n; i += m){
     while(p->nwrite == p->nread + PIPESIZE){  //DOC: pipewrite-full
       if(p->readopen == 0 || myproc()->killed){
         release(&p->lock);
         return -1;
       }
-      wakeup(&p->nread);
-      sleep(&p->nwrite, &p->lock);  //DOC: pipewrite-sleep
+      if(p->rwait){
+        p->rwait = 0;
+        wakeup(&p->nread);
+      }
+      p->wwait = 1;
+      if(sleepuser(&p->nwrite, &p->lock, addr, n) < 0){  //DOC: pipewrite-sleep
+        release(&p->lock);
+        return -1;
+      }
     }
-    p->data[p->nwrite++ % PIPESIZE] = addr[i];
+    // Copy up to the end of the free space or of the ring.
+    m = PIPESIZE - (p->nwrite - p->nread);
+    if(m > PIPESIZE - p->nwrite % PIPESIZE)
+      m = PIPESIZE - p->nwrite % PIPESIZE;
+    if(m > n - i)
+      m = n - i;
+    memmove(p->data + p->nwrite % PIPESIZE, addr + i, m);
+    p->nwrite += m;
+  }
+  if(p->rwait){  //DOC: pipewrite-wakeup1
+    p->rwait = 0;
+    wakeup(&p->nread);
   }
-  wakeup(&p->nread);  //DOC: pipewrite-wakeup1
   release(&p->lock);
   return n;
 }
@@ -100,22 +146,84 @@ pipewrite(struct pipe *p, char *addr, int n)
 int
 piperead(struct pipe *p, char *addr, int n)
 {
-  int i;
+  int i, m;
 
   acquire(&p->lock);
-  while(p->nread == p->nwrite && p->writeopen){  //DOC: pipe-empty
+  while((p->nread == p->nwrite && p->writeopen) || p->rbusy){  //DOC: pipe-empty
     if(myproc()->killed){
       release(&p->lock);
       return -1;
     }
-    sleep(&p->nread, &p->lock); //DOC: piperead-sleep
+    p->rwait = 1;
+    if(sleepuser(&p->nread, &p->lock, addr, n) < 0){ //DOC: piperead-sleep
+      release(&p->lock);
+      return -1;
+    }
   }
-  for(i = 0; i < n; i++){  //DOC: piperead-copy
-    if(p->nread == p->nwrite)
-      break;
-    addr[i] = p->data[p->nread++ % PIPESIZE];
+  for(i = 0; i < n && p->nread != p->nwrite; i += m){  //DOC: piperead-copy
+    m = p->nwrite - p->nread;
+    if(m > PIPESIZE - p->nread % PIPESIZE)
+      m = PIPESIZE - p->nread % PIPESIZE;
+    if(m > n - i)
+      m = n - i;
+    memmove(addr + i, p->data + p->nread % PIPESIZE, m);
+    p->nread += m;
+  }
+  if(p->wwait && PIPESIZE - (p->nwrite - p->nread) >= PIPELOWAT){  //DOC: piperead-wakeup
+    p->wwait = 0;
+    wakeup(&p->nwrite);
   }
-  wakeup(&p->nwrite);  //DOC: piperead-wakeup
   release(&p->lock);
   return i;
 }
+
+// Return in *run the next contiguous run of unread bytes in p,
+// at most n of them, for splice() to copy out of the ring in
+// place.  Waits for data if wait is set.  Returns the length of
+// the run, 0 at end of file or if there is nothing to read
+// without waiting, or -1 if killed.  After a run is returned,
+// other readers wait until the caller calls pipeconsume().
+int
+pipepeek(struct pipe *p, char **run, int n, int wait)
+{
+  int m;
+
+  acquire(&p->lock);
+  while((p->nread == p->nwrite && p->writeopen && wait) || p->rbusy){
+    if(myproc()->killed){
+      release(&p->lock);
+      return -1;
+    }
+    p->rwait = 1;
+    sleep(&p->nread, &p->lock);
+  }
+  m = p->nwrite - p->nread;
+  if(m > PIPESIZE - p->nread % PIPESIZE)
+    m = PIPESIZE - p->nread % PIPESIZE;
+  if(m > n)
+    m = n;
+  if(m > 0){
+    *run = p->data + p->nread % PIPESIZE;
+    p->rbusy = 1;
+  }
+  release(&p->lock);
+  return m;
+}
+
+// Finish a pipepeek(), marking m bytes of the run as read.
+void
+pipeconsume(struct pipe *p, int m)
+{
+  acquire(&p->lock);
+  p->nread += m;
+  p->rbusy = 0;
+  if(p->rwait){
+    p->rwait = 0;
+    wakeup(&p->nread);
+  }
+  if(p->wwait && PIPESIZE - (p->nwrite - p->nread) >= PIPELOWAT){
+    p->wwait = 0;
+    wakeup(&p->nwrite);
+  }
+  release(&p->lock);
+}
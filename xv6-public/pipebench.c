@@ -0,0 +1,108 @@
+// Measure pipe throughput between two processes, and the
+// round-trip latency of one byte bounced between them.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define TOTAL (8*1024*1024)
+#define BSIZE 4096
+#define TRIPS 10000
+
+char buf[BSIZE];
+
+void
+throughput(void)
+{
+  int fds[2], pid, n, got, t0, t1;
+
+  if(pipe(fds) < 0){
+    printf(1, "pipebench: pipe failed\n");
+    exit();
+  }
+  t0 = uptime();
+  pid = fork();
+  if(pid < 0){
+    printf(1, "pipebench: fork failed\n");
+    exit();
+  }
+  if(pid == 0){
+    close(fds[0]);
+    for(n = 0; n < TOTAL; n += BSIZE){
+      if(write(fds[1], buf, BSIZE) != BSIZE){
+        printf(1, "pipebench: write failed\n");
+        exit();
+      }
+    }
+    exit();
+  }
+  close(fds[1]);
+  got = 0;
+  while((n = read(fds[0], buf, sizeof(buf))) > 0)
+    got += n;
+  close(fds[0]);
+  wait();
+  t1 = uptime();
+
+  if(got != TOTAL){
+    printf(1, "pipebench: read %d bytes, want %d\n", got, TOTAL);
+    exit();
+  }
+  printf(1, "throughput: %dKB in %d ticks", TOTAL/1024, t1 - t0);
+  if(t1 > t0)
+    printf(1, ", %d KB/s", TOTAL/1024 * 100 / (t1 - t0));
+  printf(1, "\n");
+}
+
+void
+pingpong(void)
+{
+  int ping[2], pong[2], pid, i, t0, t1;
+  char c;
+
+  if(pipe(ping) < 0 || pipe(pong) < 0){
+    printf(1, "pipebench: pipe failed\n");
+    exit();
+  }
+  pid = fork();
+  if(pid < 0){
+    printf(1, "pipebench: fork failed\n");
+    exit();
+  }
+  if(pid == 0){
+    close(ping[1]);
+    close(pong[0]);
+    while(read(ping[0], &c, 1) == 1)
+      write(pong[1], &c, 1);
+    exit();
+  }
+  close(ping[0]);
+  close(pong[1]);
+  c = 'p';
+  t0 = uptime();
+  for(i = 0; i < TRIPS; i++){
+    if(write(ping[1], &c, 1) != 1 || read(pong[0], &c, 1) != 1){
+      printf(1, "pipebench: ping-pong failed\n");
+      exit();
+    }
+  }
+  t1 = uptime();
+  close(ping[1]);
+  close(pong[0]);
+  wait();
+
+  // One tick is 10ms, so 10000*ticks/TRIPS is microseconds per trip.
+  printf(1, "ping-pong: %d round trips in %d ticks, %d us each\n",
+         TRIPS, t1 - t0, (t1 - t0) * 10000 / TRIPS);
+}
+
+int
+main(int argc, char *argv[])
+{
+  printf(1, "pipebench starting\n");
+  memset(buf, 'p', sizeof(buf));
+  throughput();
+  pingpong();
+  printf(1, "pipebench ok\n");
+  exit();
+}
@@ -0,0 +1,51 @@
+// Measure the system calls and time taken by usertests-style
+// printf() output, unbuffered (one write per character, as
+// printf used to do), line-buffered and fully buffered.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+
+#define NLINES 500
+
+char *modes[] = { "full", "line", "none" };
+
+void
+run(int mode)
+{
+  int i, fd, s0, s1, t0, t1;
+
+  s0 = syscount(1);
+  t0 = uptime();
+  if(fork() == 0){
+    close(1);
+    if((fd = open("pbout", O_CREATE | O_RDWR)) != 1){
+      printf(2, "printbench: open pbout failed\n");
+      exit();
+    }
+    setvbuf(1, mode);
+    for(i = 0; i < NLINES; i++){
+      printf(1, "test %d: ", i);
+      printf(1, "pid %d, %s ok\n", getpid(), "some test");
+    }
+    exit();
+  }
+  wait();
+  t1 = uptime();
+  s1 = syscount(1);
+  printf(1, "%s buffering: %d lines, %d syscalls, %d ticks\n",
+         modes[mode], NLINES, s1 - s0, t1 - t0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  printf(1, "printbench starting\n");
+  run(_IONBF);
+  run(_IOLBF);
+  run(_IOFBF);
+  unlink("pbout");
+  printf(1, "printbench ok\n");
+  exit();
+}
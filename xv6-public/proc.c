@@ -6,28 +6,84 @@
 #include "x86.h"
 #include "proc.h"
 #include "spinlock.h"
-//#include "pstat.h"
-
+#include "sleeplock.h"
+#include "seqlock.h"
+#include "slab.h"
+#include "vmspace.h"
+
+// pstat covers the scheduling statistics (priority, ticks,
+// times, queue, total_ticks, wait_time, stats[]) so that
+// getpinfo and getpstat can read them without ptable.lock.
+// Writers hold ptable.lock.
 struct
 {
   struct spinlock lock;
+  struct seqlock pstat;
   struct proc proc[NPROC];
 } ptable;
 
 static struct proc *initproc;
 
+// Address spaces (vmspace.h).
+static struct slab vmslab;
+
 int nextpid = 1;
 extern void forkret(void);
 extern void trapret(void);
 
 static void wakeup1(void *chan);
+static void preempt(struct proc *p);
+static int startchild(struct proc *np);
+
+// The class that init, and so every process unless it asks
+// for another, starts in.  make SCHED=stride picks stride.
+#ifndef DEFAULTSCHED
+#define DEFAULTSCHED SCHED_MLFQ
+#endif
+
+// Scheduling classes, highest first (see sched.h).
+struct schedclass *schedclasses[NSCHEDCLASS] = {
+  &rtclass,
+  &mlfqclass,
+  &strideclass,
+};
+
+// Returns the class that implements SCHED_* policy, or 0.
+static struct schedclass *
+findclass(int policy)
+{
+  int i;
+
+  if (policy < 0 || policy >= 32)
+    return 0;
+  for (i = 0; i < NSCHEDCLASS; i++)
+    if (schedclasses[i]->policies & (1 << policy))
+      return schedclasses[i];
+  return 0;
+}
+
+// Returns cl's place in schedclasses[], 0 for the highest.
+static int
+classrank(struct schedclass *cl)
+{
+  int i;
+
+  for (i = 0; i < NSCHEDCLASS; i++)
+    if (schedclasses[i] == cl)
+      break;
+  return i;
+}
+
+// Is p in its class's care, so that changing class must
+// take it out of one and put it in the other?
+static int
+inclass(struct proc *p)
+{
+  return p->state == SLEEPING || p->state == RUNNABLE || p->state == RUNNING;
+}
 
 /******************** MLFQ Modification ****************************/
-//Helper function for managing queues
-struct pqueue *returnQueue(void);
-void addQueue(struct pqueue *pq, struct proc *p);
-void deleteQueue(struct pqueue *pq, struct proc *p);
-void degrade(struct pqueue *pq, struct proc *p);
+//The queues themselves are managed by mlfq.c
 
 // Global variables for debugging
 int queue0[500];
@@ -46,6 +102,7 @@ char* state2[500];
 void pinit(void)
 {
   initlock(&ptable.lock, "ptable");
+  slabinit(&vmslab, "vmspace", sizeof(struct vmspace));
 }
 
 // Must be called with interrupts disabled
@@ -112,25 +169,27 @@ allocproc(void)
   return 0;
 
 found:
-/************ MLFQ *************/
-  if(p->pid >0){  //delete unused from queue
-    
-    //check q0 
-    deleteQueue(&q0, p);
-
-    //check q1
-    deleteQueue(&q0, p);
-
-    //check q2
-    deleteQueue(&q0, p);
-  }
-
-  /************ END ************/
   p->state = EMBRYO;
+  seqwrite(&ptable.pstat);
   p->pid = nextpid++;
   p->priority = 0;
-  addQueue(&q0, p);
+  p->sched = findclass(DEFAULTSCHED);
+  p->policy = DEFAULTSCHED;
+  p->rtprio = 0;
   p->num_stat_used = 0;
+  p->nice = 0;
+  p->top = 0;
+  p->Ticks = 0;
+  p->allotused = 0;
+  memset(p->runtime, 0, sizeof(p->runtime));
+  seqwritedone(&ptable.pstat);
+  p->nsyscall = 0;
+  p->cnsyscall = 0;
+  p->cpumask = (1 << ncpu) - 1;
+  p->lastcpu = -1;
+  p->vm = 0;
+  p->vmheld = 0;
+  p->fdt = 0;
 
   release(&ptable.lock);
 
@@ -164,6 +223,7 @@ found:
 void userinit(void)
 {
   struct proc *p;
+  pde_t *pgdir;
   extern char _binary_initcode_start[], _binary_initcode_size[];
 
   /**************** MLFQ Modification ****************/
@@ -171,29 +231,16 @@ void userinit(void)
   // initialize queues and other variables
 
   TOTAL = 0;
-
-  q0.end = 0;
-  q0.numOfProc = 0;
-  q0.ticks = 1;
-  q0.priority = 0;
-
-  q1.end = 0;
-  q1.numOfProc = 0;
-  q1.ticks = 2;
-  q1.priority = 1;
-
-  q2.end = 0;
-  q2.numOfProc = 0;
-  q2.ticks = 8;
-  q2.priority = 2;
+  initQueues();
 
   p = allocproc();
 
   initproc = p;
-  if ((p->pgdir = setupkvm()) == 0)
+  if ((pgdir = setupkvm()) == 0)
+    panic("userinit: out of memory?");
+  inituvm(pgdir, _binary_initcode_start, (int)_binary_initcode_size);
+  if ((p->vm = vmspacealloc(pgdir, PGSIZE)) == 0)
     panic("userinit: out of memory?");
-  inituvm(p->pgdir, _binary_initcode_start, (int)_binary_initcode_size);
-  p->sz = PGSIZE;
   memset(p->tf, 0, sizeof(*p->tf));
   p->tf->cs = (SEG_UCODE << 3) | DPL_USER;
   p->tf->ds = (SEG_UDATA << 3) | DPL_USER;
@@ -204,7 +251,10 @@ void userinit(void)
   p->tf->eip = 0; // beginning of initcode.S
 
   safestrcpy(p->name, "initcode", sizeof(p->name));
-  p->cwd = namei("/");
+  p->leader = p;
+  if ((p->fdt = fdtablealloc()) == 0)
+    panic("userinit: out of memory?");
+  fdchdir(p->fdt, namei("/"));
 
   // this assignment to p->state lets other cores
   // run this process. the acquire forces the above
@@ -212,32 +262,182 @@ void userinit(void)
   // because the assignment might not be atomic.
   acquire(&ptable.lock);
 
+  seqwrite(&ptable.pstat);
+  p->sched->enqueue(p);
+  seqwritedone(&ptable.pstat);
   p->state = RUNNABLE;
 
   release(&ptable.lock);
 }
 
 // Grow current process's memory by n bytes.
-// Return 0 on success, -1 on failure.
+// Return the old size on success, -1 on failure.
 int growproc(int n)
 {
-  uint sz;
+  uint sz, oldsz;
   struct proc *curproc = myproc();
+  struct vmspace *vm = curproc->vm;
 
-  sz = curproc->sz;
+  if (n < 0)
+    vmshrink(vm);
+  acquiresleep(&vm->mlock);
+  sz = oldsz = vm->sz;
   if (n > 0)
   {
-    if ((sz = allocuvm(curproc->pgdir, sz, sz + n)) == 0)
+    if (sz + n < sz || sz + n > mmaplow(vm) ||
+        (sz = allocuvm(vm->pgdir, sz, sz + n)) == 0)
+    {
+      releasesleep(&vm->mlock);
       return -1;
+    }
   }
   else if (n < 0)
   {
-    if ((sz = deallocuvm(curproc->pgdir, sz, sz + n)) == 0)
+    if ((sz = deallocuvm(vm->pgdir, sz, sz + n)) == 0)
+    {
+      releasesleep(&vm->mlock);
+      vmshrinkdone(vm);
       return -1;
+    }
   }
-  curproc->sz = sz;
+  vm->sz = sz;
+  releasesleep(&vm->mlock);
   switchuvm(curproc);
-  return 0;
+  if (n < 0)
+  {
+    tlbshootdown(vm);
+    vmshrinkdone(vm);
+  }
+  return oldsz;
+}
+
+// Allocate an address space around page table pgdir, with
+// sz bytes of memory, for one process.
+struct vmspace *
+vmspacealloc(pde_t *pgdir, uint sz)
+{
+  struct vmspace *vm;
+
+  if ((vm = slaballoc(&vmslab)) == 0)
+    return 0;
+  memset(vm, 0, sizeof(*vm));
+  vm->ref = 1;
+  vm->live = 1;
+  initlock(&vm->lock, "vmspace");
+  initsleeplock(&vm->mlock, "vm");
+  vm->pgdir = pgdir;
+  vm->sz = sz;
+  return vm;
+}
+
+// Share vm with a new thread.
+static void
+vmspacedup(struct vmspace *vm)
+{
+  __sync_fetch_and_add(&vm->ref, 1);
+  __sync_fetch_and_add(&vm->live, 1);
+}
+
+// The current process, which is exiting or calling exec,
+// stops using vm.  Returns 1 if no other thread still uses
+// it, in which case the caller must remove its memory
+// mappings.
+int vmspaceleave(struct vmspace *vm)
+{
+  vmunuse(myproc());
+  return __sync_sub_and_fetch(&vm->live, 1) == 0;
+}
+
+// Drop a reference to vm, freeing it and its page table
+// with the last.
+void vmspaceput(struct vmspace *vm)
+{
+  if (__sync_sub_and_fetch(&vm->ref, 1) == 0)
+  {
+    freevm(vm->pgdir);
+    slabfree(&vmslab, vm);
+  }
+}
+
+// Hold p's address space for use, so that the user memory
+// a system call checks stays mapped until vmunuse(): waits
+// while another thread is removing memory from it.  A
+// process with no other live threads need not bother.
+void vmuse(struct proc *p)
+{
+  struct vmspace *vm = p->vm;
+
+  if (p->vmheld || vm->live == 1)
+    return;
+  acquire(&vm->lock);
+  while (vm->shrinking)
+    sleep(vm, &vm->lock);
+  vm->users++;
+  release(&vm->lock);
+  p->vmheld = 1;
+}
+
+// Stop holding p's address space, if it does.
+void vmunuse(struct proc *p)
+{
+  struct vmspace *vm = p->vm;
+
+  if (!p->vmheld)
+    return;
+  p->vmheld = 0;
+  acquire(&vm->lock);
+  if (--vm->users == 0 && vm->shrinking)
+    wakeup(vm);
+  release(&vm->lock);
+}
+
+// Wait until no other thread holds vm for use, and keep
+// them off it until vmshrinkdone(), so that the caller may
+// unmap memory that they might otherwise be using.  The
+// caller's own hold, if any, is dropped first.
+void vmshrink(struct vmspace *vm)
+{
+  vmunuse(myproc());
+  acquire(&vm->lock);
+  while (vm->shrinking)
+    sleep(vm, &vm->lock);
+  vm->shrinking = 1;
+  while (vm->users > 0)
+    sleep(vm, &vm->lock);
+  release(&vm->lock);
+}
+
+void vmshrinkdone(struct vmspace *vm)
+{
+  acquire(&vm->lock);
+  vm->shrinking = 0;
+  wakeup(vm);
+  release(&vm->lock);
+}
+
+// Like sleep(), for a system call that has checked the n
+// bytes of user memory at addr and will use them when it
+// wakes.  The wait may be long, so the thread lets go of its
+// address space meanwhile, and other threads may unmap the
+// memory; returns -1 if they did.  Like sleep(), returns
+// holding lk.
+int sleepuser(void *chan, struct spinlock *lk, char *addr, int n)
+{
+  struct proc *p = myproc();
+  int r;
+
+  if (!p->vmheld)
+  {
+    sleep(chan, lk);
+    return 0;
+  }
+  vmunuse(p);
+  sleep(chan, lk);
+  release(lk);
+  vmuse(p);
+  r = checkptr((uint)addr, n);
+  acquire(lk);
+  return r;
 }
 
 // Create a new process copying p as the parent.
@@ -245,9 +445,10 @@ int growproc(int n)
 // Caller must set state of returned proc to RUNNABLE.
 int fork(void)
 {
-  int i, pid;
   struct proc *np;
   struct proc *curproc = myproc();
+  struct vmspace *vm = curproc->vm;
+  pde_t *pgdir;
 
   // Allocate process.
   if ((np = allocproc()) == 0)
@@ -255,25 +456,50 @@ int fork(void)
     return -1;
   }
 
-  // Copy process state from proc.
-  if ((np->pgdir = copyuvm(curproc->pgdir, curproc->sz)) == 0)
+  // Copy process state from proc, holding off other
+  // threads' changes to it meanwhile.
+  acquiresleep(&vm->mlock);
+  if ((pgdir = copyuvm(vm->pgdir, vm->sz)) != 0 &&
+      (np->vm = vmspacealloc(pgdir, vm->sz)) == 0)
+    freevm(pgdir);
+  if (np->vm && mmapfork(vm, np->vm) < 0)
+  {
+    vmspaceput(np->vm);
+    np->vm = 0;
+  }
+  releasesleep(&vm->mlock);
+  if (np->vm && (np->fdt = fdtablecopy(curproc->fdt)) == 0)
+  {
+    munmapall(np->vm);
+    vmspaceput(np->vm);
+    np->vm = 0;
+  }
+  if (np->vm == 0)
   {
     kfree(np->kstack);
     np->kstack = 0;
     np->state = UNUSED;
     return -1;
   }
-  np->sz = curproc->sz;
-  np->parent = curproc;
   *np->tf = *curproc->tf;
 
   // Clear %eax so that fork returns 0 in the child.
   np->tf->eax = 0;
 
-  for (i = 0; i < NOFILE; i++)
-    if (curproc->ofile[i])
-      np->ofile[i] = filedup(curproc->ofile[i]);
-  np->cwd = idup(curproc->cwd);
+  return startchild(np);
+}
+
+// Give np, a new child of the current process with its
+// address space, descriptor table and trap frame set up,
+// the parent's scheduling settings, and let it run.
+// Returns its pid.
+static int
+startchild(struct proc *np)
+{
+  int pid;
+  struct proc *curproc = myproc();
+
+  np->cpumask = curproc->cpumask;
 
   safestrcpy(np->name, curproc->name, sizeof(curproc->name));
 
@@ -281,6 +507,37 @@ int fork(void)
 
   acquire(&ptable.lock);
 
+  // A thread's parent is its process's leader, not the thread
+  // that made it, so that any thread can join it and it lives
+  // on when its maker exits.  One made while the process is
+  // being killed, whose leader may be gone, goes to init and
+  // dies with the rest.
+  if (np->vm != curproc->vm)
+  {
+    np->leader = np;
+    np->parent = curproc;
+  }
+  else
+  {
+    np->leader = curproc->leader;
+    np->parent = curproc->leader;
+    if (curproc->killed)
+    {
+      np->parent = initproc;
+      np->killed = 1;
+    }
+  }
+
+  // Inherit the parent's scheduling policy, nice value and
+  // top level.
+  seqwrite(&ptable.pstat);
+  np->nice = curproc->nice;
+  np->top = curproc->top;
+  np->sched = curproc->sched;
+  np->policy = curproc->policy;
+  np->rtprio = curproc->rtprio;
+  np->sched->enqueue(np);
+  seqwritedone(&ptable.pstat);
   np->state = RUNNABLE;
 
   release(&ptable.lock);
@@ -288,6 +545,44 @@ int fork(void)
   return pid;
 }
 
+// Create a thread: a child process that shares the caller's
+// page table, and with it its memory, and its descriptor
+// table and working directory, and starts in fn(arg) with
+// its stack pointer just below stack.  It has a kernel stack
+// of its own, and is scheduled on its own.  Any thread of
+// the process must wait for it with join() rather than
+// wait().  When the process's leader exits, its threads are
+// killed.
+// Returns its pid.
+int clone(void (*fn)(void *), void *arg, void *stack)
+{
+  struct proc *np;
+  struct proc *curproc = myproc();
+  uint sp, ustack[2];
+
+  if ((uint)stack < sizeof(ustack))
+    return -1;
+  sp = (uint)stack - sizeof(ustack);
+  ustack[0] = 0xffffffff; // fake return PC: fn must not return
+  ustack[1] = (uint)arg;
+  if ((sp + sizeof(ustack) > curproc->vm->sz && mmapcheck(sp, sizeof(ustack)) < 0) ||
+      copyout(curproc->vm->pgdir, sp, ustack, sizeof(ustack)) < 0)
+    return -1;
+
+  if ((np = allocproc()) == 0)
+    return -1;
+
+  vmspacedup(curproc->vm);
+  np->vm = curproc->vm;
+  np->fdt = fdtabledup(curproc->fdt);
+
+  *np->tf = *curproc->tf;
+  np->tf->eip = (uint)fn;
+  np->tf->esp = sp;
+
+  return startchild(np);
+}
+
 // Exit the current process.  Does not return.
 // An exited process remains in the zombie state
 // until its parent calls wait() to find out it exited.
@@ -295,34 +590,37 @@ void exit(void)
 {
   struct proc *curproc = myproc();
   struct proc *p;
-  int fd;
 
   if (curproc == initproc)
     panic("init exiting");
 
-  // Close all open files.
-  for (fd = 0; fd < NOFILE; fd++)
-  {
-    if (curproc->ofile[fd])
-    {
-      fileclose(curproc->ofile[fd]);
-      curproc->ofile[fd] = 0;
-    }
-  }
+  // Unmap memory mappings, writing back shared file pages,
+  // unless other threads are still using them.
+  if (vmspaceleave(curproc->vm))
+    munmapall(curproc->vm);
 
-  begin_op();
-  iput(curproc->cwd);
-  end_op();
-  curproc->cwd = 0;
+  // Close all open files, unless other threads still
+  // share them.
+  fdtableput(curproc->fdt);
+  curproc->fdt = 0;
 
   acquire(&ptable.lock);
 
-  // Parent might be sleeping in wait().
+  // Parent might be sleeping in wait(), and other threads
+  // in join().
   wakeup1(curproc->parent);
+  wakeup1(curproc->vm);
 
-  // Pass abandoned children to init.
+  // If this is the process's leader, the process is exiting:
+  // kill its threads.  Pass abandoned children to init.
   for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
   {
+    if (curproc->leader == curproc && p != curproc && p->vm == curproc->vm)
+    {
+      p->killed = 1;
+      if (p->state == SLEEPING)
+        p->state = RUNNABLE;
+    }
     if (p->parent == curproc)
     {
       p->parent = initproc;
@@ -337,8 +635,31 @@ void exit(void)
   panic("zombie exit");
 }
 
+// Free zombie child p and return its pid.  Its page table
+// goes too, unless other threads still use it.
+// Caller holds ptable.lock.
+static int
+reap(struct proc *p)
+{
+  int pid;
+
+  pid = p->pid;
+  p->parent->cnsyscall += p->nsyscall + p->cnsyscall;
+  kfree(p->kstack);
+  p->kstack = 0;
+  vmspaceput(p->vm);
+  p->vm = 0;
+  p->pid = 0;
+  p->parent = 0;
+  p->name[0] = 0;
+  p->killed = 0;
+  p->state = UNUSED;
+  return pid;
+}
+
 // Wait for a child process to exit and return its pid.
-// Return -1 if this process has no children.
+// Return -1 if this process has no children.  Threads are
+// left for join().
 int wait(void)
 {
   struct proc *p;
@@ -352,21 +673,13 @@ int wait(void)
     havekids = 0;
     for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
     {
-      if (p->parent != curproc)
+      if (p->parent != curproc || p->vm == curproc->vm)
         continue;
       havekids = 1;
       if (p->state == ZOMBIE)
       {
         // Found one.
-        pid = p->pid;
-        kfree(p->kstack);
-        p->kstack = 0;
-        freevm(p->pgdir);
-        p->pid = 0;
-        p->parent = 0;
-        p->name[0] = 0;
-        p->killed = 0;
-        p->state = UNUSED;
+        pid = reap(p);
         release(&ptable.lock);
         return pid;
       }
@@ -384,97 +697,118 @@ int wait(void)
   }
 }
 
-/*************************** MLFQ Modification *****************************/
-// Helper function to manage queues
-
-//Return highest non-empty priorty queue with ready process
-struct pqueue *returnQueue(void)
+// Wait for thread pid, or for any thread if pid is 0, of
+// this process to exit, and return its pid.  Any thread may
+// join any other, whichever made it; the leader cannot be
+// joined.  Return -1 if there is no such thread.
+int join(int pid)
 {
-  if (q0.numOfProc)
-  {
-    for (int i = 0; i < q0.end; i++)
-    {
-      if (q0.queue[i]->state == RUNNABLE)
-      {
-        return &q0;
-      }
-    }
-  }
+  struct proc *p;
+  int found;
+  struct proc *curproc = myproc();
 
-  if (q1.numOfProc)
+  acquire(&ptable.lock);
+  for (;;)
   {
-    for (int i = 0; i < q1.end; i++)
+    found = 0;
+    for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
     {
-      if (q1.queue[i]->state == RUNNABLE)
+      if (p == curproc || p->leader == p || p->vm != curproc->vm ||
+          (pid && p->pid != pid))
+        continue;
+      found = 1;
+      if (p->state == ZOMBIE)
       {
-        return &q1;
+        pid = reap(p);
+        release(&ptable.lock);
+        return pid;
       }
     }
-  }
 
-  if (q2.numOfProc)
-  {
-    for (int i = 0; i < q2.end; i++)
+    if (!found || curproc->killed)
     {
-      if (q2.queue[i]->state == RUNNABLE)
-      {
-        return &q2;
-      }
+      release(&ptable.lock);
+      return -1;
     }
+
+    // Wait for a thread to exit.  (See wakeup1 call in exit.)
+    sleep(curproc->vm, &ptable.lock);
   }
-  //cprintf("No runnable processes");
-  return &q0;
 }
 
-//Adds process to end of specified priority queue
-void addQueue(struct pqueue *pq, struct proc *p)
+// For exec(): kill the current process's other threads and
+// wait for them to exit, so that the new program has the
+// process to itself.  A thread other than the leader first
+// takes the leader's place, with its pid, parent and
+// children, so that the process's parent still finds it.
+// Returns -1, having killed nothing, if the caller has been
+// killed itself, as by another thread's exec().
+int killthreads(void)
 {
+  struct proc *curproc = myproc();
+  struct vmspace *vm = curproc->vm;
+  struct proc *p, *l;
+  int pid, others;
 
-  pq->queue[pq->end] = p;
-  pq->end++;
-  pq->numOfProc++;
-
-  p->Ticks = 0;
-
-  p->priority = pq->priority;
-}
+  if (vm->live == 1)
+    return 0;
+  // The others may be waiting for this thread to let go of
+  // the address space (vmshrink()) before they can exit.
+  vmunuse(curproc);
 
-//Removes process from the start of specified priority queue
-void deleteQueue(struct pqueue *pq, struct proc *p)
-{
-  int i;
-  for(i = 0; i < pq->end; i++){
-    if (pq->queue[i] == p)
-    {
-      break;
-    }
+  acquire(&ptable.lock);
+  if (curproc->killed)
+  {
+    release(&ptable.lock);
+    return -1;
   }
-  int firstFreeIndex = pq->end;
-
-  for (int j = i; j < firstFreeIndex; j++)
+  l = curproc->leader;
+  if (l != curproc)
   {
-    pq->queue[j] = pq->queue[j + 1];
+    seqwrite(&ptable.pstat);
+    pid = l->pid;
+    l->pid = curproc->pid;
+    curproc->pid = pid;
+    seqwritedone(&ptable.pstat);
+    curproc->parent = l->parent;
+    for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+    {
+      if (p->leader == l)
+        p->leader = curproc;
+      if (p->parent == l)
+        p->parent = curproc;
+    }
+    l->parent = curproc;
   }
-  pq->end--;
-  pq->numOfProc--;
-}
 
-//Downgrades process to a lower priority queue
-void degrade(struct pqueue *pq, struct proc *p)
-{
-  if (pq->priority == 0)
+  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
   {
-    deleteQueue(&q0, p);
-    addQueue(&q1, p);
+    if (p != curproc && p->vm == vm)
+    {
+      p->killed = 1;
+      if (p->state == SLEEPING)
+        p->state = RUNNABLE;
+    }
   }
-
-  else if (pq->priority == 1)
+  for (;;)
   {
-    deleteQueue(&q1, p);
-    addQueue(&q2, p);
+    others = 0;
+    for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+      if (p != curproc && p->vm == vm && p->state != ZOMBIE)
+        others = 1;
+    if (!others)
+      break;
+    // See wakeup1 call in exit.
+    sleep(vm, &ptable.lock);
   }
+  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+    if (p != curproc && p->vm == vm)
+      reap(p);
+  release(&ptable.lock);
+  return 0;
 }
 
+/*************************** MLFQ Modification *****************************/
 //Updates queue, total_ticks and wait_time fields
 //for all processes every time a tick occurs
 void updatePstat(void)
@@ -495,46 +829,6 @@ void updatePstat(void)
   }
 }
 
-//Returns highest priority RUNNABLE process
-struct proc *returnProc(void)
-{
-  struct pqueue *pq = returnQueue();
-
-  if (pq->numOfProc == 0)
-  {
-    return 0;
-  }
-
-  for (int i = 0; i < pq->end; i++)
-  {
-    if (pq->queue[i]->state == RUNNABLE)
-    {
-      struct proc *p = pq->queue[i];
-    
-      if (i != 0)
-      {
-        //Swap with first
-        struct proc *temp = pq->queue[0];
-        pq->queue[i] = temp;
-        pq->queue[0] = p;
-      }
-      return p;
-    }
-  }
-
-  return 0;
-}
-
-//Moves process from Q2 to Q1
-void boost(struct proc *p)
-{
-  deleteQueue(&q2, p);
-  addQueue(&q0, p);
-  p->priority = 0;
-  p->stats[p->num_stat_used].priority = 0;
-}
-
-
 //PAGEBREAK: 42
 // Per-CPU process scheduler.
 // Each CPU calls scheduler() after setting itself up.
@@ -547,6 +841,8 @@ void scheduler(void)
 {
   struct proc *p;
   struct cpu *c = mycpu();
+  uint slice, left;
+  int i, j;
   c->proc = 0;
 
   for (;;)
@@ -554,25 +850,38 @@ void scheduler(void)
     // Enable interrupts on this processor.
     sti();
 
-    // Loop over process table looking for process to run.
+    // Ask each class in turn for a process to run.
     acquire(&ptable.lock);
 
-    for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+    p = 0;
+    for (i = 0; i < NSCHEDCLASS && p == 0; i++)
+      p = schedclasses[i]->pick_next(&slice);
+
+    if (p)
     {
-      //returnProc returns the highest priority RUNNABLE process
-      if (p != returnProc())
-        continue;
+      // A class ahead of p's that is throttled on this CPU
+      // takes the CPU back when the throttle lifts, not when
+      // p's slice ends.
+      for (j = 0; j < i - 1; j++)
+        if ((left = schedclasses[j]->throttled(c - cpus)) != 0 && left < slice)
+          slice = left;
 
-      struct pqueue *queue = returnQueue();
-      
-      //printQueues();
-      
       int queuepriority = p->priority;
       int count = 0;
-
-
-      //Each iteration of this loop is a tick
-      while (p->state == RUNNABLE && count < queue->ticks)
+      uint used = 0;      // microseconds of the slice used so far
+      uint64 tsc;
+      uint run;
+
+
+      //Each iteration of this loop runs p until the next tick or
+      //until it gives up the CPU, and tells p's class how long
+      //it ran.  The slice, in microseconds, comes from the class:
+      //for the MLFQ it is what is left of p's allotment at this
+      //level, so a process that sleeps before the tick still
+      //uses it up.
+      //A wakeup can cut the slice short by setting c->resched.
+      c->resched = 0;
+      while (p->state == RUNNABLE && used < slice && !c->resched)
       {
         if(p->priority == 0) 
         {
@@ -598,18 +907,32 @@ void scheduler(void)
         // before jumping back to us.
 
         c->proc = p;
+        p->lastcpu = c - cpus;
 
         switchuvm(p);
         p->state = RUNNING;
 
         // update stats variable for bookkeeping
+        seqwrite(&ptable.pstat);
+        if (count == 0)
+        {
+          p->stats[p->num_stat_used].duration = 0;
+          p->stats[p->num_stat_used].runtime = 0;
+        }
         p->stats[p->num_stat_used].start_tick = ticks;
         p->stats[p->num_stat_used].priority = p->priority;
+        seqwritedone(&ptable.pstat);
 
+        tsc = rdtsc();
         swtch(&(c->scheduler), p->context);
+        run = tsc2us(rdtsc() - tsc);
         switchkvm();
 
+        used += run;
+        seqwrite(&ptable.pstat);
         p->stats[p->num_stat_used].duration += ticks - p->stats[p->num_stat_used].start_tick;
+        p->stats[p->num_stat_used].runtime += run;
+        p->runtime[queuepriority] += run;
 
         c->proc = 0;
         
@@ -639,47 +962,21 @@ void scheduler(void)
         }
 
         count++;
-        p->Ticks++;
+        p->sched->tick(p, run);
 
         //Update queue pstat var of each process
         updatePstat();
         if (TOTAL < NTICKS)
           TOTAL++;
+        seqwritedone(&ptable.pstat);
       }
       
-      //Maintaining pstat info
-      p->ticks[queuepriority] += count;
-      p->times[p->priority] = p->times[p->priority] + 1;
-
-      // //Handles case when proc in q2 has used up its time
-      // if(p->state == RUNNABLE && p->priority == 2){
-      //   p->num_stat_used++;
-      //   deleteQueue(queue, p);
-      //   addQueue(queue, p);
-      // }
-
-      //Handles case where process uses its time slice and is demoted
-      if (p->state == RUNNABLE && (p->priority == 1 || p->priority == 0))
-      {
-        p->num_stat_used++;
-        degrade(queue, p);
-      } 
-
-      //Handles case where process in Q2 exceeds 50 ticks
-      else if (p->state == RUNNABLE && p->priority == 2 && p->Ticks >= 50)
-      {
-        p->num_stat_used++;
-        boost(p);
-     
-      }
-
-      //Handles case where process does NOT use its timeslice
-      else if (p->state == SLEEPING)
-      {
-        p->num_stat_used++;
-        deleteQueue(queue, p);
-        addQueue(queue, p);
-      }
+      //An exited process leaves its class on its way out.
+      seqwrite(&ptable.pstat);
+      p->sched->yield(p, count, used);
+      if (p->state == ZOMBIE)
+        p->sched->dequeue(p);
+      seqwritedone(&ptable.pstat);
     }
     release(&ptable.lock);
   }
@@ -790,7 +1087,205 @@ wakeup1(void *chan)
 
   for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
     if (p->state == SLEEPING && p->chan == chan)
+    {
       p->state = RUNNABLE;
+      preempt(p);
+    }
+}
+
+// Should newly runnable p take the CPU from cur?  Always if
+// p's class comes before cur's, and never if it comes after;
+// if they share a class, the class decides.
+static int
+preempts(struct proc *p, struct proc *cur)
+{
+  if (p->sched != cur->sched)
+    return classrank(p->sched) < classrank(cur->sched);
+  return p->sched->preempt(p, cur);
+}
+
+// p has just become runnable.  If every CPU is running
+// something of lower priority, ask the one running the
+// lowest-priority process to give up the CPU the next time
+// it returns from the kernel, rather than at the end of
+// its slice.  Another CPU is kicked with an IPI so that
+// it notices right away.  CPUs on which p's class is
+// throttled are left alone.  Caller holds ptable.lock.
+static void
+preempt(struct proc *p)
+{
+  struct cpu *c, *victim;
+
+  victim = 0;
+  for (c = cpus; c < &cpus[ncpu]; c++)
+  {
+    if (!(p->cpumask & (1 << (c - cpus))) || p->sched->throttled(c - cpus))
+      continue;
+    if (c->proc == 0)
+      return; // an idle CPU will pick p up
+    if (preempts(p, c->proc) &&
+        (victim == 0 || preempts(victim->proc, c->proc)))
+      victim = c;
+  }
+  if (victim)
+  {
+    victim->resched = 1;
+    ipiresched(victim);
+  }
+}
+
+// Can p run on this CPU, and would it rather?  Used by
+// mlfq.c to pick a process: -1 if p's affinity mask leaves
+// this CPU out, 1 if p last ran here and may find its cache
+// and TLB still warm (or has never run), 0 if it would have
+// to move.  Caller holds ptable.lock.
+int cpuPreference(struct proc *p)
+{
+  int id = cpuid();
+
+  if (!(p->cpumask & (1 << id)))
+    return -1;
+  return p->lastcpu == id || p->lastcpu < 0;
+}
+
+// Restrict process pid (or the caller, if pid is 0) to the
+// CPUs in mask.  If it is running on a CPU that is no longer
+// allowed, that CPU is asked to reschedule.
+int setaffinity(int pid, uint mask)
+{
+  struct proc *p;
+  struct cpu *c;
+
+  mask &= (1 << ncpu) - 1;
+  if (mask == 0)
+    return -1;
+  acquire(&ptable.lock);
+  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+  {
+    if (p->state == UNUSED || (pid ? p->pid != pid : p != myproc()))
+      continue;
+    p->cpumask = mask;
+    if (p->state == RUNNING && !(mask & (1 << p->lastcpu)))
+    {
+      c = &cpus[p->lastcpu];
+      c->resched = 1;
+      ipiresched(c);
+    }
+    release(&ptable.lock);
+    return 0;
+  }
+  release(&ptable.lock);
+  return -1;
+}
+
+// Set the nice value of process pid (or the caller, if pid
+// is 0) to n, and the highest priority level it may reach to
+// top, moving it down now if it is above top.
+int setnice(int pid, int n, int top)
+{
+  struct proc *p;
+
+  if (n < NICEMIN || n > NICEMAX || top < 0 || top > 2)
+    return -1;
+  acquire(&ptable.lock);
+  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+  {
+    if (p->state == UNUSED || (pid ? p->pid != pid : p != myproc()))
+      continue;
+    seqwrite(&ptable.pstat);
+    p->nice = n;
+    p->top = top;
+    if (p->sched == &mlfqclass && inclass(p))
+      capLevel(p);
+    seqwritedone(&ptable.pstat);
+    release(&ptable.lock);
+    return 0;
+  }
+  release(&ptable.lock);
+  return -1;
+}
+
+// Set the scheduling policy of process pid (or the caller,
+// if pid is 0), and its real-time priority, which must be
+// between RTPRIOMIN and RTPRIOMAX for SCHED_FIFO and SCHED_RR
+// and is ignored otherwise.  A process that changes class
+// joins the new one as a newcomer would.  If it is running,
+// its CPU is asked to reschedule so that the new policy gets
+// to choose.
+int setsched(int pid, int policy, int prio)
+{
+  struct schedclass *cl;
+  struct proc *p;
+  struct cpu *c;
+
+  if ((cl = findclass(policy)) == 0)
+    return -1;
+  if (policy == SCHED_FIFO || policy == SCHED_RR)
+  {
+    if (prio < RTPRIOMIN || prio > RTPRIOMAX)
+      return -1;
+  }
+  else
+    prio = 0;
+  acquire(&ptable.lock);
+  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+  {
+    if (p->state == UNUSED || (pid ? p->pid != pid : p != myproc()))
+      continue;
+    if (p->state == ZOMBIE)
+      break;
+    seqwrite(&ptable.pstat);
+    p->policy = policy;
+    p->rtprio = prio;
+    if (p->sched != cl && inclass(p))
+    {
+      p->sched->dequeue(p);
+      cl->enqueue(p);
+    }
+    p->sched = cl;
+    seqwritedone(&ptable.pstat);
+    if (p->state == RUNNING)
+    {
+      c = &cpus[p->lastcpu];
+      c->resched = 1;
+      ipiresched(c);
+    }
+    release(&ptable.lock);
+    return 0;
+  }
+  release(&ptable.lock);
+  return -1;
+}
+
+// Return the affinity mask of process pid, or of the caller
+// if pid is 0.
+int getaffinity(int pid)
+{
+  struct proc *p;
+  int mask;
+
+  acquire(&ptable.lock);
+  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+  {
+    if (p->state == UNUSED || (pid ? p->pid != pid : p != myproc()))
+      continue;
+    mask = p->cpumask;
+    release(&ptable.lock);
+    return mask;
+  }
+  release(&ptable.lock);
+  return -1;
+}
+
+// Should the current process give up the CPU early?
+int needresched(void)
+{
+  int r;
+
+  pushcli();
+  r = mycpu()->resched;
+  popcli();
+  return r;
 }
 
 // Wake up all processes sleeping on chan.
@@ -883,28 +1378,93 @@ void print_pstat_info(struct proc *p)
 int
 getpinfo(int pid){
   struct proc* p;
-
-  acquire(&ptable.lock);
+  struct sched_stat_t st;
+  char name[16];
+  int times[3], pticks[3], runtime[3];
+  int i, n;
+  uint s;
+
+  // Copy out under ptable.pstat, then print with no lock held:
+  // cprintf to the console is slow, and holding ptable.lock
+  // across it would stall every scheduler.
   for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-    if(p->pid == pid){
-      cprintf("*****************\nname = %s, pid = %d\ntimes: {%d, %d, %d}\nticks: {%d, %d, %d}\n*******************\n", 
-      p->name, p->pid,
-      p->times[0],
-      p->times[1],
-      p->times[2],
-      p->ticks[0],
-      p->ticks[1],
-      p->ticks[2]);
-      for(int i = 0; i < p->num_stat_used; i++){
-        cprintf("start = %d, duration = %d, priority = %d\n", p->stats[i].start_tick, p->stats[i].duration, p->stats[i].priority);
+    do {
+      s = seqbegin(&ptable.pstat);
+      if(p->pid != pid)
+        break;
+      safestrcpy(name, p->name, sizeof(name));
+      for(i = 0; i < 3; i++){
+        times[i] = p->times[i];
+        pticks[i] = p->ticks[i];
+        runtime[i] = p->runtime[i];
       }
-      release(&ptable.lock);
-      return 0;
+      n = p->num_stat_used;
+    } while(seqretry(&ptable.pstat, s));
+    if(p->pid != pid)
+      continue;
+    cprintf("*****************\nname = %s, pid = %d\ntimes: {%d, %d, %d}\nticks: {%d, %d, %d}\nruntime (us): {%d, %d, %d}\n*******************\n", 
+    name, pid,
+    times[0],
+    times[1],
+    times[2],
+    pticks[0],
+    pticks[1],
+    pticks[2],
+    runtime[0],
+    runtime[1],
+    runtime[2]);
+    if(n > NSCHEDSTATS)
+      n = NSCHEDSTATS;
+    for(i = 0; i < n; i++){
+      do {
+        s = seqbegin(&ptable.pstat);
+        st = p->stats[i];
+      } while(seqretry(&ptable.pstat, s));
+      cprintf("start = %d, duration = %d, priority = %d, runtime = %dus\n", st.start_tick, st.duration, st.priority, st.runtime);
     }
+    return 0;
   }
-  release(&ptable.lock);
   return 0;
 }
 
+// Copy the scheduling statistics of process pid into *ps,
+// which the caller has checked lies in user memory.
+// Takes no locks, so it can be polled without slowing
+// down the schedulers.
+int
+getpstat(int pid, struct pstat *ps)
+{
+  struct proc *p;
+  uint s;
+  int i, found;
+
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+    do {
+      s = seqbegin(&ptable.pstat);
+      found = p->pid == pid && p->state != UNUSED;
+      if(!found)
+        break;
+      ps->pid = pid;
+      ps->name = 0;
+      ps->priority = p->priority;
+      ps->nice = p->nice;
+      ps->top = p->top;
+      ps->policy = p->policy;
+      ps->rtprio = p->rtprio;
+      for(i = 0; i < 3; i++){
+        ps->ticks[i] = p->ticks[i];
+        ps->runtime[i] = p->runtime[i];
+        ps->times[i] = p->times[i];
+      }
+      memmove(ps->queue, p->queue, sizeof(ps->queue));
+      ps->total_ticks = p->total_ticks;
+      ps->wait_time = p->wait_time;
+    } while(seqretry(&ptable.pstat, s));
+    if(found)
+      return 0;
+  }
+  return -1;
+}
+
 
 
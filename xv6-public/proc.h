@@ -11,6 +11,7 @@ struct cpu
   int ncli;                  // Depth of pushcli nesting.
   int intena;                // Were interrupts enabled before pushcli?
   struct proc *proc;         // The process running on this cpu or null
+  int resched;               // A higher-priority process became runnable
 };
 
 extern struct cpu cpus[NCPU];
@@ -44,18 +45,8 @@ int qnum0;
 int qnum1;
 int qnum2;
 */
-struct pqueue
-{
-  struct proc *queue[NPROC];
-  int ticks;
-  int end;
-  int numOfProc;
-  int priority;
-};
-
-struct pqueue q0;
-struct pqueue q1;
-struct pqueue q2;
+#include "mlfq.h"
+#include "sched.h"
 
 int TOTAL;
 
@@ -72,24 +63,36 @@ enum procstate
 // Per-process state
 struct proc
 {
-  uint sz;                    // Size of process memory (bytes)
-  pde_t *pgdir;               // Page table
+  struct vmspace *vm;         // Address space (vmspace.h)
+  int vmheld;                 // Holds vm for use (vmuse())
   char *kstack;               // Bottom of kernel stack for this process
   enum procstate state;       // Process state
   int pid;                    // Process ID
   struct proc *parent;        // Parent process
+  struct proc *leader;        // Thread that started the process; itself
+                              // unless it is a thread made by clone()
   struct trapframe *tf;       // Trap frame for current syscall
   struct context *context;    // swtch() here to run process
   void *chan;                 // If non-zero, sleeping on chan
   int killed;                 // If non-zero, have been killed
-  struct file *ofile[NOFILE]; // Open files
-  struct inode *cwd;          // Current directory
+  struct fdtable *fdt;        // Open files and current directory
   char name[16];              // Process name (debugging)
+  uint nsyscall;              // System calls made
+  uint cnsyscall;             // System calls made by waited-for children
+  uint cpumask;               // CPUs it may run on, bit i for cpus[i]
+  int lastcpu;                // CPU it last ran on, or -1
+  struct schedclass *sched;   // Scheduling class (sched.h)
+  int policy;                 // Scheduling policy, SCHED_*
+  int rtprio;                 // Real-time priority, in SCHED_FIFO and SCHED_RR
+  uint64 pass;                // Virtual time, in the stride class
 
   //Added to fill out pstat
 
   int priority; // Added for proj3
+  int nice;     // NICEMIN..NICEMAX, scales slices and allotments
+  int top;      // highest priority level it may be in
   int ticks[3];
+  int runtime[3]; // microseconds, from the TSC
   int times[3];
   //NTICKS = 500 (MACRO)
   int queue[500];
@@ -99,7 +102,8 @@ struct proc
   int num_stat_used;
 
   //Not in pstat
-  int Ticks;
+  int Ticks;      // times scheduled since entering this queue
+  uint allotused; // microseconds run since entering this queue
 };
 
 // Process memory is laid out contiguously, low addresses first:
@@ -8,6 +8,7 @@ struct sched_stat_t
  int start_tick;            //the number of ticks when this process is scheduled
  int duration;              //number of ticks the process is running before it gives up the CPU
  int priority;              //the priority of the process when it's scheduled 
+ int runtime;               //microseconds it actually ran, measured with the TSC
 
 };
 
@@ -18,10 +19,18 @@ struct pstat
     int pid;                // PID of each process
     char *name;             // name of the process
     int priority;           // current priority level of each process (0-2)
+    int nice;               // nice value (NICEMIN..NICEMAX, see mlfq.h)
+    int top;                // highest priority level it may reach (0-2)
+    int policy;             // scheduling policy, SCHED_* (see sched.h)
+    int rtprio;             // real-time priority, for SCHED_FIFO and SCHED_RR
     int ticks[3];           // number of ticks each process used the last time it was
                             // scheduled in each priority queue
                             // cannot be greater than the time-slice for each queue
 
+    int runtime[3];         // microseconds run in each priority queue, measured
+                            // with the TSC; unlike ticks, counts runs shorter
+                            // than a tick
+
     int times[3];           // number of times each process was scheduled at each of 3
                             // priority queues
     int queue[NTICKS];      //queue that a RUNNABLE process is sitting in during each tick
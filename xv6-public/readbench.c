@@ -0,0 +1,67 @@
+// Measure read() throughput from a cached file,
+// with 64KB and with 512-byte buffers.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "fsstat.h"
+
+#define FILESZ (64*1024)
+#define ROUNDS 200
+
+char buf[FILESZ];
+
+void
+run(int bsize)
+{
+  struct fsstat st0, st1;
+  int fd, i, n, t0, t1, kb;
+
+  fsstat(&st0);
+  t0 = uptime();
+  for(i = 0; i < ROUNDS; i++){
+    if((fd = open("rbfile", O_RDONLY)) < 0){
+      printf(1, "readbench: open rbfile failed\n");
+      exit();
+    }
+    while((n = read(fd, buf, bsize)) > 0)
+      ;
+    close(fd);
+  }
+  t1 = uptime();
+  fsstat(&st1);
+
+  kb = FILESZ / 1024 * ROUNDS;
+  printf(1, "read %dKB with %d-byte buffers: %d ticks", kb, bsize, t1 - t0);
+  if(t1 > t0)
+    printf(1, ", %d KB/s", kb * 100 / (t1 - t0));
+  printf(1, " (page hits %d, misses %d)\n",
+         st1.phits - st0.phits, st1.pmisses - st0.pmisses);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int fd;
+
+  printf(1, "readbench starting\n");
+
+  memset(buf, 'r', sizeof(buf));
+  if((fd = open("rbfile", O_CREATE | O_RDWR)) < 0){
+    printf(1, "readbench: create rbfile failed\n");
+    exit();
+  }
+  if(write(fd, buf, FILESZ) != FILESZ){
+    printf(1, "readbench: write rbfile failed\n");
+    exit();
+  }
+  close(fd);
+
+  run(FILESZ);
+  run(512);
+
+  unlink("rbfile");
+  printf(1, "readbench ok\n");
+  exit();
+}
@@ -0,0 +1,146 @@
+// Real-time scheduling class: SCHED_FIFO and SCHED_RR.
+//
+// A real-time process has a static priority from RTPRIOMIN to
+// RTPRIOMAX, and the runnable one with the highest priority
+// runs, ahead of every process in the MLFQ and stride classes;
+// when it wakes up it preempts them at once.  Among processes
+// of equal priority, the one that has waited longest goes
+// first.  A SCHED_FIFO process runs until it sleeps or one of
+// higher priority wakes; a SCHED_RR process also goes to the
+// back of its priority after each RTSLICE.
+//
+// So that a runaway real-time process cannot lock up the
+// machine, each CPU may spend at most RTRUNTIME of every
+// RTPERIOD running real-time processes.  Once it has, the
+// class is throttled on that CPU, and the other classes get
+// the rest of the period: a waking real-time process does not
+// preempt them there, and the scheduler cuts their slices
+// short at the period's end so that the class gets the CPU
+// back within a tick of the throttle lifting.
+//
+// Callers hold ptable.lock.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "mmu.h"
+#include "x86.h"
+#include "proc.h"
+
+#define RTSLICE   TICKUS                      // SCHED_RR slice, microseconds
+#define RTPERIOD  100                         // ticks
+#define RTRUNTIME (RTPERIOD * TICKUS / 100 * 95)
+                                              // microseconds of each
+                                              // period, per CPU
+
+// Processes in the class, longest waiting first.
+static struct proc *members[NPROC];
+static int nmembers;
+
+// Real-time CPU time used on each CPU in the period that
+// started at tick periodstart[].
+static uint rtused[NCPU];
+static uint periodstart[NCPU];
+
+static void
+rtenqueue(struct proc *p)
+{
+  members[nmembers++] = p;
+}
+
+static void
+rtdequeue(struct proc *p)
+{
+  int i;
+
+  for(i = 0; i < nmembers; i++){
+    if(members[i] == p){
+      memmove(&members[i], &members[i+1], (nmembers - i - 1) * sizeof(members[0]));
+      nmembers--;
+      return;
+    }
+  }
+}
+
+// Microseconds of real-time running cpu has left in the
+// current period.
+static uint
+budget(int cpu)
+{
+  if(ticks - periodstart[cpu] >= RTPERIOD){
+    periodstart[cpu] = ticks;
+    rtused[cpu] = 0;
+  }
+  if(rtused[cpu] >= RTRUNTIME)
+    return 0;
+  return RTRUNTIME - rtused[cpu];
+}
+
+// Highest priority first, then longest waiting.  Affinity
+// masks are obeyed, but the CPU a process last ran on is not
+// taken into account.
+static struct proc*
+rtpicknext(uint *slice)
+{
+  struct proc *p, *best;
+  uint left;
+  int i;
+
+  if((left = budget(cpuid())) == 0)
+    return 0;
+  best = 0;
+  for(i = 0; i < nmembers; i++){
+    p = members[i];
+    if(p->state != RUNNABLE || cpuPreference(p) < 0)
+      continue;
+    if(best == 0 || p->rtprio > best->rtprio)
+      best = p;
+  }
+  if(best){
+    *slice = left;
+    if(best->policy == SCHED_RR && RTSLICE < left)
+      *slice = RTSLICE;
+  }
+  return best;
+}
+
+static void
+rttick(struct proc *p, uint run)
+{
+  rtused[cpuid()] += run;
+}
+
+// A process that sleeps, or used up its round-robin slice,
+// goes behind the others of its priority.
+static void
+rtyield(struct proc *p, int count, uint used)
+{
+  if(p->state == SLEEPING || (p->policy == SCHED_RR && used >= RTSLICE)){
+    rtdequeue(p);
+    rtenqueue(p);
+  }
+}
+
+static int
+rtpreempt(struct proc *p, struct proc *cur)
+{
+  return p->rtprio > cur->rtprio;
+}
+
+static uint
+rtthrottled(int cpu)
+{
+  uint end, now;
+
+  if(budget(cpu) > 0)
+    return 0;
+  end = periodstart[cpu] + RTPERIOD;
+  now = ticks;
+  return end > now ? (end - now) * TICKUS : 1;
+}
+
+struct schedclass rtclass = {
+  "rt", 1 << SCHED_FIFO | 1 << SCHED_RR,
+  rtenqueue, rtdequeue, rtpicknext, rttick, rtyield, rtpreempt,
+  rtthrottled,
+};
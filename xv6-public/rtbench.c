@@ -0,0 +1,124 @@
+// Measure the wake-up jitter of a periodic task under full CPU
+// load.  Twice as many CPU hogs as CPUs run in the MLFQ while
+// a task wakes every tick with sleep(1) and notes the time,
+// first as an ordinary MLFQ process and then as SCHED_FIFO.
+// Each interval between wakeups should be one tick; the worst
+// one, less a tick, is the worst wake latency.
+//
+// Then check the real-time throttle: a SCHED_FIFO process
+// spins forever on CPU 0, and an ordinary process pinned there
+// should still get about 5% of the CPU.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "x86.h"
+#include "sched.h"
+#include "pstat.h"
+
+#define NPERIODS  200
+#define THROTTLE  300    // ticks the throttle check runs for
+
+static struct pstat ps;
+
+// Wake up every tick NPERIODS times and report the intervals.
+static void
+periodic(char *what)
+{
+  uint64 prev, t;
+  uint d, min, max;
+  int i, late;
+
+  min = ~0;
+  max = late = 0;
+  sleep(1);
+  prev = rdtsc();
+  for(i = 0; i < NPERIODS; i++){
+    sleep(1);
+    t = rdtsc();
+    d = cyclestous(t - prev);
+    prev = t;
+    if(d < min)
+      min = d;
+    if(d > max)
+      max = d;
+    if(d >= 15000)
+      late++;
+  }
+  printf(1, "  %s: interval min %d us, max %d us; worst latency %d us, %d of %d periods late\n",
+         what, min, max, max > 10000 ? max - 10000 : 0, late, NPERIODS);
+}
+
+// Run periodic() in a child with the given policy.
+static void
+measure(char *what, int policy, int prio)
+{
+  if(fork() == 0){
+    if(setsched(0, policy, prio) < 0){
+      printf(1, "rtbench: setsched failed\n");
+      exit();
+    }
+    periodic(what);
+    exit();
+  }
+  wait();
+}
+
+// Returns the percentage of CPU 0 this process got while a
+// runaway SCHED_FIFO process had it.
+static int
+throttle(void)
+{
+  int pid, before, end;
+
+  if(sched_setaffinity(0, 1) < 0){
+    printf(1, "rtbench: sched_setaffinity failed\n");
+    return 0;
+  }
+  if((pid = fork()) == 0){
+    setsched(0, SCHED_FIFO, RTPRIOMAX);
+    for(;;)
+      ;
+  }
+  getpstat(getpid(), &ps);
+  before = ps.runtime[0] + ps.runtime[1] + ps.runtime[2];
+  end = uptime() + THROTTLE;
+  while(uptime() < end)
+    ;
+  getpstat(getpid(), &ps);
+  kill(pid);
+  wait();
+  return (ps.runtime[0] + ps.runtime[1] + ps.runtime[2] - before) /
+         (THROTTLE * 100);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int pids[2*NCPU], i, n, pct;
+
+  printf(1, "rtbench starting\n");
+  tickcycles();
+
+  n = 2 * ncpus();
+  for(i = 0; i < n; i++)
+    if((pids[i] = fork()) == 0)
+      for(;;)
+        ;
+  printf(1, "periodic task with %d hogs:\n", n);
+  measure("mlfq", SCHED_MLFQ, 0);
+  measure("fifo", SCHED_FIFO, RTPRIOMIN);
+  for(i = 0; i < n; i++){
+    kill(pids[i]);
+    wait();
+  }
+
+  pct = throttle();
+  printf(1, "runaway SCHED_FIFO process: others got %d%% of its CPU\n", pct);
+  if(pct < 1){
+    printf(1, "rtbench FAILED\n");
+    exit();
+  }
+  printf(1, "rtbench ok\n");
+  exit();
+}
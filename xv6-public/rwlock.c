@@ -0,0 +1,63 @@
+// Reader-writer spin locks, for tables that are searched
+// much more often than they are changed.  Like spinlocks,
+// they keep interrupts off while held.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "x86.h"
+#include "rwlock.h"
+
+void
+initrwlock(struct rwlock *lk, char *name)
+{
+  lk->name = name;
+  lk->readers = 0;
+  lk->writer = 0;
+}
+
+void
+acquireread(struct rwlock *lk)
+{
+  pushcli();
+  for(;;){
+    while(*(volatile uint*)&lk->writer)
+      cpu_relax();
+    __sync_fetch_and_add(&lk->readers, 1);
+    // Back out if a writer got in first.
+    if(*(volatile uint*)&lk->writer == 0)
+      break;
+    __sync_fetch_and_sub(&lk->readers, 1);
+  }
+  __sync_synchronize();
+}
+
+void
+releaseread(struct rwlock *lk)
+{
+  __sync_synchronize();
+  if(__sync_fetch_and_sub(&lk->readers, 1) == 0)
+    panic("releaseread");
+  popcli();
+}
+
+void
+acquirewrite(struct rwlock *lk)
+{
+  pushcli();
+  while(xchg(&lk->writer, 1) != 0)
+    cpu_relax();
+  while(*(volatile uint*)&lk->readers)
+    cpu_relax();
+  __sync_synchronize();
+}
+
+void
+releasewrite(struct rwlock *lk)
+{
+  if(lk->writer == 0)
+    panic("releasewrite");
+  __sync_synchronize();
+  xchg(&lk->writer, 0);
+  popcli();
+}
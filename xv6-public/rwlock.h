@@ -0,0 +1,8 @@
+// Reader-writer spin lock: any number of readers, or one
+// writer.  A waiting writer holds off new readers, so a
+// steady stream of readers cannot starve it.
+struct rwlock {
+  uint readers;      // readers holding the lock
+  uint writer;       // a writer holds or is waiting for the lock
+  char *name;        // Name of lock.
+};
@@ -0,0 +1,51 @@
+// Scheduling policies, for setsched().
+#define SCHED_MLFQ    0   // multi-level feedback queue (mlfq.c)
+#define SCHED_STRIDE  1   // proportional share by nice weight (stride.c)
+#define SCHED_FIFO    2   // real-time, runs until it blocks (rt.c)
+#define SCHED_RR      3   // real-time, round robin at each priority (rt.c)
+
+// Real-time priorities, for SCHED_FIFO and SCHED_RR.  Higher
+// runs first.
+#define RTPRIOMIN     1
+#define RTPRIOMAX     99
+
+#define NSCHEDCLASS   3
+
+// The CPU scheduler (scheduler() in proc.c) asks each class in
+// turn, in order of schedclasses[], for a process to run, so a
+// runnable process in an earlier class always runs ahead of
+// one in a later class.  Within a class, the class decides.
+//
+// A class may implement more than one policy; p->policy says
+// which one a process asked for.
+//
+// Every operation is called with ptable.lock held.  A process
+// belongs to its class from when it first becomes runnable
+// until it exits, sleeping or not.
+struct proc;
+
+struct schedclass {
+  char *name;
+  int policies;                               // 1 << SCHED_* for each
+                                              // policy it implements
+  void (*enqueue)(struct proc *p);            // p joins the class
+  void (*dequeue)(struct proc *p);            // p leaves the class
+  struct proc *(*pick_next)(uint *slice);     // choose a process to run
+                                              // on this CPU, and for how
+                                              // many microseconds; or 0
+  void (*tick)(struct proc *p, uint run);     // p ran for run microseconds
+  void (*yield)(struct proc *p, int count, uint used);
+                                              // p's slice ended after count
+                                              // runs and used microseconds
+  int (*preempt)(struct proc *p, struct proc *cur);
+                                              // should newly runnable p
+                                              // take cur's CPU?
+  uint (*throttled)(int cpu);                 // microseconds until the class
+                                              // may run on cpu again, or 0
+                                              // if it may now
+};
+
+extern struct schedclass rtclass;
+extern struct schedclass mlfqclass;
+extern struct schedclass strideclass;
+extern struct schedclass *schedclasses[NSCHEDCLASS];
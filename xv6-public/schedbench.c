@@ -0,0 +1,168 @@
+// Run the same workload under each scheduling class: CPU-bound
+// workers at nice -5, 0, 0 and 5, alongside an interactive
+// process that sleeps a tick at a time.  For each class it
+// reports
+//
+//   throughput: the workers' loop iterations per tick;
+//   fairness:   Jain's index, in thousandths, of each worker's
+//               CPU share over the share its nice weight calls
+//               for (1000 is perfectly proportional);
+//   latency:    how long the interactive process's sleep(1)
+//               calls took: median, 99th percentile and worst.
+//
+// usage: schedbench [mlfq|stride]
+// Run it with make CPUS=1 qemu, so that the workers compete.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "x86.h"
+#include "sched.h"
+
+#define NWORKERS  4
+#define DURATION  500    // ticks each class runs for
+#define NSLEEPS   DURATION
+
+static int nices[NWORKERS] = { -5, 0, 0, 5 };
+static int weights[NWORKERS] = { 3121, 1024, 1024, 335 };  // see mlfq.c
+
+static uint us[NSLEEPS];
+
+// Count loop iterations until tick end and report them on
+// fd, after worker number w.
+static void
+worker(int fd, int w, int end)
+{
+  volatile int x;
+  int i, msg[2];
+
+  x = 0;
+  msg[0] = w;
+  for(msg[1] = 0; uptime() < end; msg[1]++)
+    for(i = 0; i < 1000; i++)
+      x += i;
+  write(fd, msg, sizeof(msg));
+  exit();
+}
+
+// Time sleep(1) calls until tick end; returns how many.
+static int
+interactive(int end)
+{
+  uint64 t0;
+  int n;
+
+  for(n = 0; n < NSLEEPS && uptime() < end; n++){
+    t0 = rdtsc();
+    sleep(1);
+    us[n] = cyclestous(rdtsc() - t0);
+  }
+  return n;
+}
+
+static void
+sort(uint *a, int n)
+{
+  int i, j;
+  uint t;
+
+  for(i = 1; i < n; i++){
+    t = a[i];
+    for(j = i; j > 0 && a[j-1] > t; j--)
+      a[j] = a[j-1];
+    a[j] = t;
+  }
+}
+
+static void
+run(char *name, int policy)
+{
+  int fds[2], count[NWORKERS], msg[2], i, n, end;
+  uint total, sumw, share, ideal, x, sx, sxx;
+
+  if(setsched(0, policy, 0) < 0){
+    printf(1, "schedbench: setsched %s failed\n", name);
+    exit();
+  }
+  if(pipe(fds) < 0){
+    printf(1, "schedbench: pipe failed\n");
+    exit();
+  }
+  end = uptime() + DURATION;
+  for(i = 0; i < NWORKERS; i++){
+    if(fork() == 0){
+      close(fds[0]);
+      nice(0, nices[i], 0);
+      worker(fds[1], i, end);
+    }
+  }
+  close(fds[1]);
+  n = interactive(end);
+
+  total = 0;
+  for(i = 0; i < NWORKERS; i++){
+    if(read(fds[0], msg, sizeof(msg)) != sizeof(msg) ||
+       msg[0] < 0 || msg[0] >= NWORKERS){
+      printf(1, "schedbench: short read\n");
+      exit();
+    }
+    count[msg[0]] = msg[1];
+  }
+  close(fds[0]);
+  for(i = 0; i < NWORKERS; i++){
+    wait();
+    total += count[i];
+  }
+
+  sumw = 0;
+  for(i = 0; i < NWORKERS; i++)
+    sumw += weights[i];
+  printf(1, "%s:\n", name);
+  sx = sxx = 0;
+  for(i = 0; i < NWORKERS; i++){
+    // Shares in thousandths.
+    share = count[i] / (total / 1000 + 1);
+    ideal = weights[i] * 1000 / sumw;
+    printf(1, "  nice %d: %d iterations, %d/1000 of the work (%d/1000 by weight)\n",
+           nices[i], count[i], share, ideal);
+    x = share * 1000 / ideal;
+    sx += x;
+    sxx += x * x;
+  }
+  printf(1, "  throughput %d iterations/tick\n", total / DURATION);
+  printf(1, "  fairness %d/1000\n", sxx ? sx * sx / (NWORKERS * sxx / 1000 + 1) : 0);
+  if(n == 0)
+    return;
+  sort(us, n);
+  printf(1, "  sleep(1) latency: median %d us, p99 %d us, max %d us (%d calls)\n",
+         us[n / 2], us[n * 99 / 100], us[n - 1], n);
+}
+
+int
+main(int argc, char *argv[])
+{
+  printf(1, "schedbench starting\n");
+  tickcycles();
+  if(argc > 1 && strcmp(argv[1], "mlfq") != 0 && strcmp(argv[1], "stride") != 0){
+    printf(2, "usage: schedbench [mlfq|stride]\n");
+    exit();
+  }
+  // Each class runs in a child of its own, so that it leaves
+  // this process's class as it found it.
+  if(argc < 2 || strcmp(argv[1], "mlfq") == 0){
+    if(fork() == 0){
+      run("mlfq", SCHED_MLFQ);
+      exit();
+    }
+    wait();
+  }
+  if(argc < 2 || strcmp(argv[1], "stride") == 0){
+    if(fork() == 0){
+      run("stride", SCHED_STRIDE);
+      exit();
+    }
+    wait();
+  }
+  printf(1, "schedbench ok\n");
+  exit();
+}
@@ -0,0 +1,54 @@
+// Sequence lock, for data that is read often and written
+// rarely or by one writer at a time.  Writers are serialized
+// by some other lock and bump seq around each update, so seq
+// is odd while an update is in progress.  Readers never block
+// writers: they copy the data and retry if seq moved.
+//
+//   do {
+//     s = seqbegin(&sl);
+//     ... copy the data ...
+//   } while(seqretry(&sl, s));
+struct seqlock {
+  uint seq;
+};
+
+static inline void
+seqinit(struct seqlock *sl)
+{
+  sl->seq = 0;
+}
+
+// Start an update.  Caller holds the writers' lock.
+static inline void
+seqwrite(struct seqlock *sl)
+{
+  sl->seq++;
+  __sync_synchronize();
+}
+
+// Finish an update.
+static inline void
+seqwritedone(struct seqlock *sl)
+{
+  __sync_synchronize();
+  sl->seq++;
+}
+
+static inline uint
+seqbegin(struct seqlock *sl)
+{
+  uint s;
+
+  while((s = *(volatile uint*)&sl->seq) & 1)
+    cpu_relax();
+  __sync_synchronize();
+  return s;
+}
+
+// Did a writer change the data since seqbegin() returned s?
+static inline int
+seqretry(struct seqlock *sl, uint s)
+{
+  __sync_synchronize();
+  return *(volatile uint*)&sl->seq != s;
+}
@@ -0,0 +1,139 @@
+// Object caches for kernel structures smaller than a page.
+//
+// Each slab hands out objects of one size, carved from pages
+// taken from kalloc().  Every CPU keeps a magazine of free
+// objects; slaballoc() and slabfree() only disable interrupts
+// to use it.  When a magazine runs empty or full, half a
+// magazine moves from or to the slab's depot under the slab
+// lock, so the lock is taken once per MAGSIZE/2 operations.
+//
+// Pages are never returned to kalloc(); a slab keeps the
+// pages for the most objects it has ever had in use.
+//
+// Interface:
+// * Declare a struct slab and call slabinit() once at boot.
+// * slaballoc() returns an uninitialized object, or 0.
+// * slabfree() gives it back.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "mmu.h"
+#include "spinlock.h"
+#include "slab.h"
+#include "slabstat.h"
+
+static struct slab *slabs;  // all slabs, for slabstat()
+
+void
+slabinit(struct slab *s, char *name, uint size)
+{
+  memset(s, 0, sizeof(*s));
+  initlock(&s->lock, name);
+  s->name = name;
+  // Room for the free list link, and word alignment.
+  if(size < sizeof(void*))
+    size = sizeof(void*);
+  s->size = (size + 3) & ~3;
+  if(s->size > PGSIZE)
+    panic("slabinit");
+  s->next = slabs;
+  slabs = s;
+}
+
+// Move up to half a magazine of objects from the depot
+// to m, carving a new page if the depot is empty.
+static void
+slabrefill(struct slab *s, struct magazine *m)
+{
+  char *page, *obj;
+
+  acquire(&s->lock);
+  if(s->depot == 0 && (page = kalloc()) != 0){
+    s->npages++;
+    for(obj = page; obj + s->size <= page + PGSIZE; obj += s->size){
+      *(void**)obj = s->depot;
+      s->depot = obj;
+    }
+  }
+  while(m->n < MAGSIZE/2 && s->depot){
+    m->obj[m->n++] = s->depot;
+    s->depot = *(void**)s->depot;
+  }
+  release(&s->lock);
+}
+
+// Move half of the full magazine m to the depot.
+static void
+slabdrain(struct slab *s, struct magazine *m)
+{
+  void *obj;
+
+  acquire(&s->lock);
+  while(m->n > MAGSIZE/2){
+    obj = m->obj[--m->n];
+    *(void**)obj = s->depot;
+    s->depot = obj;
+  }
+  release(&s->lock);
+}
+
+void*
+slaballoc(struct slab *s)
+{
+  struct magazine *m;
+  void *obj;
+
+  pushcli();
+  m = &s->mag[cpuid()];
+  if(m->n == 0)
+    slabrefill(s, m);
+  obj = 0;
+  if(m->n > 0){
+    obj = m->obj[--m->n];
+    m->nalloc++;
+  }
+  popcli();
+  return obj;
+}
+
+void
+slabfree(struct slab *s, void *obj)
+{
+  struct magazine *m;
+
+  pushcli();
+  m = &s->mag[cpuid()];
+  if(m->n == MAGSIZE)
+    slabdrain(s, m);
+  m->obj[m->n++] = obj;
+  m->nfree++;
+  popcli();
+}
+
+// Copy statistics for the i'th slab to *st.
+// Returns -1 if there is no such slab.
+int
+slabstat(int i, struct slabstat *st)
+{
+  struct slab *s;
+  int c;
+
+  for(s = slabs; s && i > 0; s = s->next)
+    i--;
+  if(s == 0 || i < 0)
+    return -1;
+  memset(st, 0, sizeof(*st));
+  safestrcpy(st->name, s->name, sizeof(st->name));
+  st->size = s->size;
+  acquire(&s->lock);
+  st->npages = s->npages;
+  release(&s->lock);
+  // The per-CPU counts are read without stopping other CPUs,
+  // so they may be a few operations out of date.
+  for(c = 0; c < NCPU; c++){
+    st->nalloc += s->mag[c].nalloc;
+    st->inuse += s->mag[c].nalloc - s->mag[c].nfree;
+  }
+  return 0;
+}
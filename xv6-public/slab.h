@@ -0,0 +1,21 @@
+#define MAGSIZE 16  // objects in a per-CPU magazine
+
+// Objects cached by one CPU, so that most allocations
+// and frees take no lock.  Only touched with interrupts off.
+struct magazine {
+  int n;                // objects in obj[]
+  void *obj[MAGSIZE];
+  uint nalloc;          // slaballoc() calls on this CPU
+  uint nfree;           // slabfree() calls on this CPU
+};
+
+// A cache of equal-sized kernel objects (see slab.c).
+struct slab {
+  char *name;
+  uint size;            // object size in bytes
+  struct spinlock lock; // protects depot and npages
+  void *depot;          // free objects, linked through their first word
+  uint npages;          // pages taken from kalloc()
+  struct magazine mag[NCPU];
+  struct slab *next;    // list of all slabs, for slabstat()
+};
@@ -0,0 +1,72 @@
+// Report the kernel object caches, and time the system calls
+// that allocate pipes, files and inodes from them.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "slabstat.h"
+
+#define ROUNDS 2000
+#define NPIPES 7
+
+void
+report(char *when)
+{
+  struct slabstat st;
+  int i;
+
+  printf(1, "%s:\n", when);
+  for(i = 0; slabstat(i, &st) == 0; i++)
+    printf(1, "  %s: %d in use, %d bytes each, %d pages (%d bytes), %d allocs\n",
+           st.name, st.inuse, st.size, st.npages, st.npages * 4096, st.nalloc);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int fds[NPIPES][2], fd, i, t0, t1;
+
+  printf(1, "slabbench starting\n");
+  report("at start");
+
+  // Hold several pipes open at once to show their footprint.
+  for(i = 0; i < NPIPES; i++)
+    if(pipe(fds[i]) < 0){
+      printf(1, "slabbench: pipe failed\n");
+      exit();
+    }
+  report("with 7 more pipes open");
+  for(i = 0; i < NPIPES; i++){
+    close(fds[i][0]);
+    close(fds[i][1]);
+  }
+
+  t0 = uptime();
+  for(i = 0; i < ROUNDS; i++){
+    if(pipe(fds[0]) < 0){
+      printf(1, "slabbench: pipe failed\n");
+      exit();
+    }
+    close(fds[0][0]);
+    close(fds[0][1]);
+  }
+  t1 = uptime();
+  printf(1, "%d pipe+close: %d ticks\n", ROUNDS, t1 - t0);
+
+  // Each open allocates a struct file.
+  t0 = uptime();
+  for(i = 0; i < ROUNDS; i++){
+    if((fd = open(i % 2 ? "README" : "cat", O_RDONLY)) < 0){
+      printf(1, "slabbench: open failed\n");
+      exit();
+    }
+    close(fd);
+  }
+  t1 = uptime();
+  printf(1, "%d open+close: %d ticks\n", ROUNDS, t1 - t0);
+
+  report("at end");
+  printf(1, "slabbench ok\n");
+  exit();
+}
@@ -0,0 +1,9 @@
+// Kernel object cache statistics, returned by the slabstat() system call.
+struct slabstat
+{
+  char name[16];
+  uint size;        // object size in bytes
+  uint inuse;       // objects allocated and not yet freed
+  uint npages;      // pages taken from kalloc()
+  uint nalloc;      // slaballoc() calls
+};
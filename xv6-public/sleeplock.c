@@ -17,17 +17,64 @@ initsleeplock(struct sleeplock *lk, char *name)
   lk->name = name;
   lk->locked = 0;
   lk->pid = 0;
+  lk->owner = 0;
+  lk->cpu = -1;
+  lk->class = lockclassfor(name, 1);
 }
 
+// Is the holder of lk running on another CPU right now?
+// Caller must hold lk->lk.
+static int
+ownerrunning(struct sleeplock *lk)
+{
+  struct cpu *c;
+
+  if(lk->owner == 0 || lk->cpu < 0)
+    return 0;
+  c = &cpus[lk->cpu];
+  return c != mycpu() && c->proc == lk->owner;
+}
+
+// Acquire the lock, sleeping until it is free.  If the holder
+// is running on another CPU it will probably release the lock
+// soon, so first spin for up to SLEEPSPIN cycles, which is
+// cheaper than two trips through the scheduler.
 void
 acquiresleep(struct sleeplock *lk)
 {
+  struct proc *owner;
+  struct cpu *c;
+  uint64 t0, t;
+  int slept, spun;
+
+  t0 = rdtsc();
+  slept = 0;
+  spun = 0;
   acquire(&lk->lk);
   while (lk->locked) {
+    if (!spun && ownerrunning(lk)) {
+      spun = 1;
+      owner = lk->owner;
+      c = &cpus[lk->cpu];
+      release(&lk->lk);
+      t = rdtsc();
+      while (*(volatile uint*)&lk->locked &&
+             *(struct proc* volatile*)&c->proc == owner &&
+             rdtsc() - t < SLEEPSPIN)
+        cpu_relax();
+      acquire(&lk->lk);
+      continue;
+    }
+    slept = 1;
+    spun = 0;
     sleep(lk, &lk->lk);
   }
   lk->locked = 1;
   lk->pid = myproc()->pid;
+  lk->owner = myproc();
+  lk->cpu = mycpu() - cpus;
+  lockcount(lk->class, rdtsc() - t0, slept);
+  lk->tsc = rdtsc();
   release(&lk->lk);
 }
 
@@ -35,8 +82,11 @@ void
 releasesleep(struct sleeplock *lk)
 {
   acquire(&lk->lk);
+  lockhold(lk->class, rdtsc() - lk->tsc);
   lk->locked = 0;
   lk->pid = 0;
+  lk->owner = 0;
+  lk->cpu = -1;
   wakeup(lk);
   release(&lk->lk);
 }
@@ -6,5 +6,13 @@ struct sleeplock {
   // For debugging:
   char *name;        // Name of lock.
   int pid;           // Process holding lock
+
+  // For adaptive spinning (see acquiresleep()):
+  struct proc *owner; // Process holding lock
+  int cpu;           // CPU it acquired the lock on
+
+  // For statistics (see lockstat()):
+  struct lockclass *class;
+  uint64 tsc;        // rdtsc() when acquired
 };
 
@@ -8,13 +8,131 @@
 #include "mmu.h"
 #include "proc.h"
 #include "spinlock.h"
+#include "lockstat.h"
+
+// Locks are counted by name: all pipe locks, say, share one
+// lockclass, and sleep locks have classes of their own.  Each
+// CPU updates only its own counters, and only with interrupts
+// off, so the counters need no lock of their own.
+struct lockcpu {
+  uint nacquire;
+  uint ncontended;
+  uint64 wait;      // cycles spent spinning or sleeping
+  uint64 maxhold;   // longest hold, in cycles
+  uint waithist[NLOCKHIST];
+  uint holdhist[NLOCKHIST];
+};
+
+struct lockclass {
+  char *name;
+  int sleep;        // counts sleep locks, not spinlocks
+  struct lockcpu cpu[NCPU];
+};
+
+// The last class collects the locks that do not fit.
+static struct lockclass lockclass[NLOCKCLASS];
+static uint nlockclass;
+static uint classlock;   // guards adding to lockclass[]
+
+static struct lockclass*
+findclass(char *name, int sleep)
+{
+  struct lockclass *c;
+  uint i;
+
+  for(i = 0; i < nlockclass; i++){
+    c = &lockclass[i];
+    if(c->sleep == sleep && (c->name == name || strncmp(c->name, name, 16) == 0))
+      return c;
+  }
+  return 0;
+}
+
+// Return the statistics class for locks called name.
+struct lockclass*
+lockclassfor(char *name, int sleep)
+{
+  struct lockclass *c;
+
+  if((c = findclass(name, sleep)) != 0)
+    return c;
+  while(xchg(&classlock, 1) != 0)
+    ;
+  if((c = findclass(name, sleep)) == 0){
+    c = &lockclass[nlockclass];
+    if(nlockclass < NLOCKCLASS-1){
+      c->name = name;
+      c->sleep = sleep;
+    } else
+      c = &lockclass[NLOCKCLASS-1];
+    if(nlockclass < NLOCKCLASS){
+      if(nlockclass == NLOCKCLASS-1)
+        c->name = "(other)";
+      __sync_synchronize();
+      nlockclass++;
+    }
+  }
+  xchg(&classlock, 0);
+  return c;
+}
+
+// Histogram bucket for a time in cycles: bucket b
+// counts times below 4^(b+1), the last one the rest.
+static int
+lockbucket(uint64 cycles)
+{
+  uint hi, lo;
+  int b;
+
+  hi = cycles >> 32;
+  lo = cycles;
+  if(hi)
+    b = (63 - __builtin_clz(hi)) / 2;
+  else if(lo)
+    b = (31 - __builtin_clz(lo)) / 2;
+  else
+    b = 0;
+  return b < NLOCKHIST ? b : NLOCKHIST-1;
+}
+
+// Count an acquisition of a lock of class c that waited
+// wait cycles.  Caller must have interrupts off.
+void
+lockcount(struct lockclass *c, uint64 wait, int contended)
+{
+  struct lockcpu *s;
+
+  s = &c->cpu[mycpu() - cpus];
+  s->nacquire++;
+  if(contended){
+    s->ncontended++;
+    s->wait += wait;
+  }
+  s->waithist[lockbucket(wait)]++;
+}
+
+// Count the release of a lock of class c held for hold
+// cycles.  Caller must have interrupts off.
+void
+lockhold(struct lockclass *c, uint64 hold)
+{
+  struct lockcpu *s;
+
+  s = &c->cpu[mycpu() - cpus];
+  if(hold > s->maxhold)
+    s->maxhold = hold;
+  s->holdhist[lockbucket(hold)]++;
+}
 
 void
 initlock(struct spinlock *lk, char *name)
 {
   lk->name = name;
   lk->locked = 0;
+  lk->next = 0;
+  lk->owner = 0;
   lk->cpu = 0;
+  lk->class = lockclassfor(name, 0);
 }
 
 // Acquire the lock.
@@ -24,22 +142,38 @@ initlock(struct spinlock *lk, char *name)
 void
 acquire(struct spinlock *lk)
 {
+  uint ticket;
+  uint64 spin;
+
   pushcli(); // disable interrupts to avoid deadlock.
   if(holding(lk))
     panic("acquire");
 
-  // The xchg is atomic.
-  while(xchg(&lk->locked, 1) != 0)
-    ;
+  // Take a ticket and wait for it to be served.
+  // The fetch-and-add is atomic.
+  ticket = __sync_fetch_and_add(&lk->next, 1);
+  spin = 0;
+  if(*(volatile uint*)&lk->owner != ticket){
+    spin = rdtsc();
+    while(*(volatile uint*)&lk->owner != ticket)
+      cpu_relax();
+    spin = rdtsc() - spin;
+  }
 
   // Tell the C compiler and the processor to not move loads or stores
   // past this point, to ensure that the critical section's memory
   // references happen after the lock is acquired.
   __sync_synchronize();
 
-  // Record info about lock acquisition for debugging.
+  lk->locked = 1;
   lk->cpu = mycpu();
+  lockcount(lk->class, spin, spin != 0);
+  lk->tsc = rdtsc();
+
+#ifdef LOCKDEBUG
+  // Record info about lock acquisition for debugging.
   getcallerpcs(&lk, lk->pcs);
+#endif
 }
 
 // Release the lock.
@@ -49,8 +183,13 @@ release(struct spinlock *lk)
   if(!holding(lk))
     panic("release");
 
+  lockhold(lk->class, rdtsc() - lk->tsc);
+
+#ifdef LOCKDEBUG
   lk->pcs[0] = 0;
+#endif
   lk->cpu = 0;
+  lk->locked = 0;
 
   // Tell the C compiler and the processor to not move loads or stores
   // past this point, to ensure that all the stores in the critical
@@ -59,14 +198,58 @@ release(struct spinlock *lk)
   // stores; __sync_synchronize() tells them both not to.
   __sync_synchronize();
 
-  // Release the lock, equivalent to lk->locked = 0.
-  // This code can't use a C assignment, since it might
-  // not be atomic. A real OS would use C atomics here.
-  asm volatile("movl $0, %0" : "+m" (lk->locked) : );
+  // Serve the next ticket.  Only the holder writes owner,
+  // so a plain increment is enough.
+  asm volatile("incl %0" : "+m" (lk->owner) : );
 
   popcli();
 }
 
+// Copy the statistics of the i'th lock class, summed
+// over CPUs, to *st.  Returns -1 if there is no such class.
+int
+lockstat(int i, struct lockstat *st)
+{
+  struct lockclass *c;
+  struct lockcpu *s;
+  uint64 wait, maxhold;
+  int n, b;
+
+  if(i < 0 || i >= nlockclass)
+    return -1;
+  c = &lockclass[i];
+  memset(st, 0, sizeof(*st));
+  safestrcpy(st->name, c->name, sizeof(st->name));
+  st->sleep = c->sleep;
+  wait = maxhold = 0;
+  for(n = 0; n < NCPU; n++){
+    s = &c->cpu[n];
+    st->nacquire += s->nacquire;
+    st->ncontended += s->ncontended;
+    wait += s->wait;
+    if(s->maxhold > maxhold)
+      maxhold = s->maxhold;
+    for(b = 0; b < NLOCKHIST; b++){
+      st->waithist[b] += s->waithist[b];
+      st->holdhist[b] += s->holdhist[b];
+    }
+  }
+  st->wait = wait >> 10;
+  st->maxhold = maxhold > 0xffffffff ? 0xffffffff : maxhold;
+  return 0;
+}
+
+// Zero the statistics of every lock class.  Other CPUs
+// are not stopped, so a few concurrent updates may survive.
+void
+lockstatreset(void)
+{
+  uint i;
+
+  for(i = 0; i < nlockclass; i++)
+    memset(lockclass[i].cpu, 0, sizeof(lockclass[i].cpu));
+}
+
 // Record the current call stack in pcs[] by following the %ebp chain.
 void
 getcallerpcs(void *v, uint pcs[])
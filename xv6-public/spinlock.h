@@ -1,11 +1,21 @@
 // Mutual exclusion lock.
+// A ticket lock: acquire() takes the next ticket and spins
+// until that ticket is served, so CPUs get the lock in the
+// order they asked for it.
 struct spinlock {
   uint locked;       // Is the lock held?
+  uint next;         // Next ticket to hand out
+  uint owner;        // Ticket being served
 
   // For debugging:
   char *name;        // Name of lock.
   struct cpu *cpu;   // The cpu holding the lock.
+#ifdef LOCKDEBUG
   uint pcs[10];      // The call stack (an array of program counters)
                      // that locked the lock.
-};
+#endif
 
+  // For statistics (see lockstat()):
+  struct lockclass *class; // Statistics shared by locks of this name
+  uint64 tsc;        // rdtsc() when acquired
+};
@@ -0,0 +1,155 @@
+// Compare `cat file | wc` against the same pipeline with
+// splice() feeding the pipe, and copying a pipe into a file
+// with read()/write() against splice().
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+
+#define FILESZ (64*1024)
+#define ROUNDS 10
+
+char buf[512];
+
+// Feed sbfile into fd, like cat, or with splice().
+void
+feed(int fd, int usesplice)
+{
+  int in, n;
+
+  if((in = open("sbfile", O_RDONLY)) < 0){
+    printf(2, "splicebench: open sbfile failed\n");
+    exit();
+  }
+  if(usesplice){
+    while((n = splice(in, fd, 4096)) > 0)
+      ;
+  } else {
+    while((n = read(in, buf, sizeof(buf))) > 0)
+      if(write(fd, buf, n) != n){
+        printf(2, "splicebench: write failed\n");
+        exit();
+      }
+  }
+  if(n < 0){
+    printf(2, "splicebench: feed failed\n");
+    exit();
+  }
+  close(in);
+}
+
+// Run `feed | wc` ROUNDS times.
+void
+pipeline(int usesplice)
+{
+  char *argv[] = { "wc", 0 };
+  int fds[2], i, t0, t1;
+
+  t0 = uptime();
+  for(i = 0; i < ROUNDS; i++){
+    if(pipe(fds) < 0){
+      printf(1, "splicebench: pipe failed\n");
+      exit();
+    }
+    if(fork() == 0){
+      close(fds[0]);
+      feed(fds[1], usesplice);
+      exit();
+    }
+    if(fork() == 0){
+      close(0);
+      dup(fds[0]);
+      close(fds[0]);
+      close(fds[1]);
+      close(1);
+      if(open("sbout", O_CREATE | O_RDWR) != 1)
+        exit();
+      exec("wc", argv);
+      exit();
+    }
+    close(fds[0]);
+    close(fds[1]);
+    wait();
+    wait();
+  }
+  t1 = uptime();
+  printf(1, "%s | wc x%d: %d ticks\n", usesplice ? "splice" : "cat",
+         ROUNDS, t1 - t0);
+}
+
+// Copy FILESZ bytes written into a pipe out to sbcopy.
+void
+drain(int usesplice)
+{
+  struct stat st;
+  int fds[2], fd, i, n, t0, t1;
+
+  if(pipe(fds) < 0){
+    printf(1, "splicebench: pipe failed\n");
+    exit();
+  }
+  t0 = uptime();
+  if(fork() == 0){
+    close(fds[0]);
+    feed(fds[1], 0);
+    exit();
+  }
+  close(fds[1]);
+  unlink("sbcopy");
+  if((fd = open("sbcopy", O_CREATE | O_RDWR)) < 0){
+    printf(1, "splicebench: create sbcopy failed\n");
+    exit();
+  }
+  for(i = 0; ; i += n){
+    if(usesplice)
+      n = splice(fds[0], fd, 4096);
+    else if((n = read(fds[0], buf, sizeof(buf))) > 0 && write(fd, buf, n) != n)
+      n = -1;
+    if(n <= 0)
+      break;
+  }
+  close(fds[0]);
+  wait();
+  t1 = uptime();
+  if(n < 0 || fstat(fd, &st) < 0 || st.size != FILESZ){
+    printf(1, "splicebench: copied %d bytes, want %d\n", i, FILESZ);
+    exit();
+  }
+  close(fd);
+  printf(1, "pipe to file with %s: %d ticks\n",
+         usesplice ? "splice" : "read/write", t1 - t0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int fd, i;
+
+  printf(1, "splicebench starting\n");
+
+  if((fd = open("sbfile", O_CREATE | O_RDWR)) < 0){
+    printf(1, "splicebench: create sbfile failed\n");
+    exit();
+  }
+  for(i = 0; i < sizeof(buf); i++)
+    buf[i] = i % 64 == 63 ? '\n' : 'a' + i % 26;
+  for(i = 0; i < FILESZ; i += sizeof(buf)){
+    if(write(fd, buf, sizeof(buf)) != sizeof(buf)){
+      printf(1, "splicebench: write sbfile failed\n");
+      exit();
+    }
+  }
+  close(fd);
+
+  pipeline(0);
+  pipeline(1);
+  drain(0);
+  drain(1);
+
+  unlink("sbout");
+  unlink("sbcopy");
+  unlink("sbfile");
+  printf(1, "splicebench ok\n");
+  exit();
+}
@@ -0,0 +1,108 @@
+// Stride scheduling: a proportional-share scheduling class.
+//
+// Each process holds tickets equal to the weight of its nice
+// value (niceWeight() in mlfq.c), so nice means the same here
+// as in the MLFQ, and gets a share of the CPU in proportion to
+// them.  A process's pass advances by its stride, STRIDE1 over
+// its tickets, for every microsecond it runs, and the runnable
+// process with the lowest pass runs next, for one tick.
+//
+// A process that sleeps must not bank the time it was away and
+// then hog the CPU to catch up, so a pass that has fallen
+// behind the class's virtual time, the pass of the process
+// picked last, is brought up to it.  A process joining the
+// class starts at the virtual time too.
+//
+// Woken processes do not preempt: they wait for the running
+// process's slice to end.  Callers hold ptable.lock.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "mmu.h"
+#include "x86.h"
+#include "proc.h"
+
+#define STRIDE1 (1 << 20)
+
+static struct proc *members[NPROC];  // processes in the class
+static int nmembers;
+static uint64 vtime;                 // pass of the process picked last
+
+static void
+strideenqueue(struct proc *p)
+{
+  members[nmembers++] = p;
+  p->pass = vtime;
+}
+
+static void
+stridedequeue(struct proc *p)
+{
+  int i;
+
+  for(i = 0; i < nmembers; i++){
+    if(members[i] == p){
+      members[i] = members[--nmembers];
+      return;
+    }
+  }
+}
+
+// Lowest pass first; among equals, one that last ran on this
+// CPU.
+static struct proc*
+stridepicknext(uint *slice)
+{
+  struct proc *p, *best;
+  int i, pref, bestpref;
+
+  best = 0;
+  bestpref = 0;
+  for(i = 0; i < nmembers; i++){
+    p = members[i];
+    if(p->state != RUNNABLE || (pref = cpuPreference(p)) < 0)
+      continue;
+    if(p->pass < vtime)
+      p->pass = vtime;
+    if(best == 0 || p->pass < best->pass ||
+       (p->pass == best->pass && pref > bestpref)){
+      best = p;
+      bestpref = pref;
+    }
+  }
+  if(best){
+    vtime = best->pass;
+    *slice = TICKUS;
+  }
+  return best;
+}
+
+static void
+stridetick(struct proc *p, uint run)
+{
+  p->pass += (uint64)(STRIDE1 / niceWeight(p->nice)) * run;
+}
+
+static void
+strideyield(struct proc *p, int count, uint used)
+{
+}
+
+static int
+stridepreempt(struct proc *p, struct proc *cur)
+{
+  return 0;
+}
+
+static uint
+stridethrottled(int cpu)
+{
+  return 0;
+}
+
+struct schedclass strideclass = {
+  "stride", 1 << SCHED_STRIDE,
+  strideenqueue, stridedequeue, stridepicknext, stridetick, strideyield,
+  stridepreempt, stridethrottled,
+};
@@ -4,6 +4,9 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "proc.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "vmspace.h"
 #include "x86.h"
 #include "syscall.h"
 
@@ -12,34 +15,51 @@
 // Arguments on the stack, from the user call to the C
 // library system call function. The saved user %esp points
 // to a saved program counter, and then the first argument.
+//
+// While it runs, a system call holds its process's address
+// space for use (see vmuse() in proc.c), so other threads
+// cannot unmap the user memory it has checked.  They can still
+// write to it, so anything the kernel must check and then rely
+// on, like a string's nul or an iovec array, is copied first.
 
 // Fetch the int at addr from the current process.
 int fetchint(uint addr, int *ip)
 {
-  struct proc *curproc = myproc();
-
-  if (addr >= curproc->sz || addr + 4 > curproc->sz)
+  if (checkptr(addr, 4) < 0)
     return -1;
   *ip = *(int *)(addr);
   return 0;
 }
 
-// Fetch the nul-terminated string at addr from the current process.
-// Doesn't actually copy the string - just sets *pp to point at it.
-// Returns length of string, not including nul.
-int fetchstr(uint addr, char **pp)
+// Copy the nul-terminated string at addr in the current process
+// into buf, which holds max bytes.  Returns length of string, not
+// including nul, or -1 if it runs off the end of the process's
+// memory (or of the mmap() region it starts in) or does not fit.
+int fetchstr(uint addr, char *buf, int max)
 {
   char *s, *ep;
   struct proc *curproc = myproc();
+  uint end;
+  int i;
 
-  if (addr >= curproc->sz)
-    return -1;
-  *pp = (char *)addr;
-  ep = (char *)curproc->sz;
-  for (s = *pp; s < ep; s++)
+  if (addr < curproc->vm->sz)
+    ep = (char *)curproc->vm->sz;
+  else
   {
-    if (*s == 0)
-      return s - *pp;
+    // Fault in as much of the region as the copy may read.
+    if ((end = mmapend(addr)) == 0)
+      return -1;
+    if (end - addr > (uint)max)
+      end = addr + max;
+    if (mmapcheck(addr, end - addr) < 0)
+      return -1;
+    ep = (char *)end;
+  }
+  for (s = (char *)addr, i = 0; s < ep && i < max; s++, i++)
+  {
+    buf[i] = *s;
+    if (buf[i] == 0)
+      return i;
   }
   return -1;
 }
@@ -50,32 +70,46 @@ int argint(int n, int *ip)
   return fetchint((myproc()->tf->esp) + 4 + 4 * n, ip);
 }
 
+// Check that the size bytes at addr lie within the process
+// address space, or inside one of its mmap() regions, whose
+// pages are faulted in first.
+int checkptr(uint addr, int size)
+{
+  struct proc *curproc = myproc();
+
+  if (size < 0 || addr + size < addr)
+    return -1;
+  if ((addr >= curproc->vm->sz || addr + size > curproc->vm->sz) &&
+      mmapcheck(addr, size) < 0)
+    return -1;
+  return 0;
+}
+
 // Fetch the nth word-sized system call argument as a pointer
 // to a block of memory of size bytes.  Check that the pointer
-// lies within the process address space.
+// is valid (see checkptr).
 int argptr(int n, char **pp, int size)
 {
   int i;
-  struct proc *curproc = myproc();
 
   if (argint(n, &i) < 0)
     return -1;
-  if (size < 0 || (uint)i >= curproc->sz || (uint)i + size > curproc->sz)
+  if (checkptr((uint)i, size) < 0)
     return -1;
   *pp = (char *)i;
   return 0;
 }
 
-// Fetch the nth word-sized system call argument as a string pointer.
-// Check that the pointer is valid and the string is nul-terminated.
-// (There is no shared writable memory, so the string can't change
-// between this check and being used by the kernel.)
-int argstr(int n, char **pp)
+// Fetch the nth word-sized system call argument as a string pointer
+// and copy the string into buf, which holds max bytes.  The kernel
+// uses the copy: another thread, or a process sharing a mapping,
+// could overwrite the string's nul after it had been checked.
+int argstr(int n, char *buf, int max)
 {
   int addr;
   if (argint(n, &addr) < 0)
     return -1;
-  return fetchstr(addr, pp);
+  return fetchstr(addr, buf, max);
 }
 
 extern int sys_chdir(void);
@@ -100,6 +134,23 @@ extern int sys_wait(void);
 extern int sys_write(void);
 extern int sys_uptime(void);
 extern int sys_getpinfo(void);
+extern int sys_fsstat(void);
+extern int sys_mmap(void);
+extern int sys_munmap(void);
+extern int sys_splice(void);
+extern int sys_readv(void);
+extern int sys_writev(void);
+extern int sys_syscount(void);
+extern int sys_slabstat(void);
+extern int sys_lockstat(void);
+extern int sys_getpstat(void);
+extern int sys_ipiping(void);
+extern int sys_sched_setaffinity(void);
+extern int sys_sched_getaffinity(void);
+extern int sys_nice(void);
+extern int sys_setsched(void);
+extern int sys_clone(void);
+extern int sys_join(void);
 
 static int (*syscalls[])(void) = {
     [SYS_fork] sys_fork,
@@ -124,6 +175,23 @@ static int (*syscalls[])(void) = {
     [SYS_mkdir] sys_mkdir,
     [SYS_close] sys_close,
     [SYS_getpinfo] sys_getpinfo,
+    [SYS_fsstat] sys_fsstat,
+    [SYS_mmap] sys_mmap,
+    [SYS_munmap] sys_munmap,
+    [SYS_splice] sys_splice,
+    [SYS_readv] sys_readv,
+    [SYS_writev] sys_writev,
+    [SYS_syscount] sys_syscount,
+    [SYS_slabstat] sys_slabstat,
+    [SYS_lockstat] sys_lockstat,
+    [SYS_getpstat] sys_getpstat,
+    [SYS_ipiping] sys_ipiping,
+    [SYS_sched_setaffinity] sys_sched_setaffinity,
+    [SYS_sched_getaffinity] sys_sched_getaffinity,
+    [SYS_nice] sys_nice,
+    [SYS_setsched] sys_setsched,
+    [SYS_clone] sys_clone,
+    [SYS_join] sys_join,
 };
 
 void syscall(void)
@@ -132,11 +200,15 @@ void syscall(void)
   struct proc *curproc = myproc();
 
   num = curproc->tf->eax;
+  curproc->nsyscall++;
   if (num > 0 && num < NELEM(syscalls) && syscalls[num])
   {
-
+    // Calls that sleep for long, or remove memory, let go
+    // once they have fetched their arguments.
+    vmuse(curproc);
     curproc->tf->eax = syscalls[num]();
-    }
+    vmunuse(curproc);
+  }
   else
   {
     cprintf("%d %s: unknown sys call %d\n",
@@ -20,4 +20,21 @@
 #define SYS_link   19
 #define SYS_mkdir  20
 #define SYS_close  21
-#define SYS_getpinfo 22
\ No newline at end of file
+#define SYS_getpinfo 22
+#define SYS_fsstat 23
+#define SYS_mmap   24
+#define SYS_munmap 25
+#define SYS_splice 26
+#define SYS_readv  27
+#define SYS_writev 28
+#define SYS_syscount 29
+#define SYS_slabstat 30
+#define SYS_lockstat 31
+#define SYS_getpstat 32
+#define SYS_ipiping 33
+#define SYS_sched_setaffinity 34
+#define SYS_sched_getaffinity 35
+#define SYS_nice 36
+#define SYS_setsched 37
+#define SYS_clone 38
+#define SYS_join 39
\ No newline at end of file
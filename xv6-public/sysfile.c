@@ -15,9 +15,14 @@
 #include "sleeplock.h"
 #include "file.h"
 #include "fcntl.h"
+#include "fsstat.h"
+#include "mman.h"
+#include "uio.h"
 
 // Fetch the nth word-sized system call argument as a file descriptor
 // and return both the descriptor and the corresponding struct file.
+// The file comes with a reference of its own (see fdget()), which
+// the caller must drop with fileclose().
 static int
 argfd(int n, int *pfd, struct file **pf)
 {
@@ -26,32 +31,17 @@ argfd(int n, int *pfd, struct file **pf)
 
   if(argint(n, &fd) < 0)
     return -1;
-  if(fd < 0 || fd >= NOFILE || (f=myproc()->ofile[fd]) == 0)
+  if((f = fdget(myproc()->fdt, fd)) == 0)
     return -1;
   if(pfd)
     *pfd = fd;
   if(pf)
     *pf = f;
+  else
+    fileclose(f);
   return 0;
 }
 
-// Allocate a file descriptor for the given file.
-// Takes over file reference from caller on success.
-static int
-fdalloc(struct file *f)
-{
-  int fd;
-  struct proc *curproc = myproc();
-
-  for(fd = 0; fd < NOFILE; fd++){
-    if(curproc->ofile[fd] == 0){
-      curproc->ofile[fd] = f;
-      return fd;
-    }
-  }
-  return -1;
-}
-
 int
 sys_dup(void)
 {
@@ -60,9 +50,8 @@ sys_dup(void)
 
   if(argfd(0, 0, &f) < 0)
     return -1;
-  if((fd=fdalloc(f)) < 0)
-    return -1;
-  filedup(f);
+  if((fd=fdalloc(myproc()->fdt, f)) < 0)
+    fileclose(f);
   return fd;
 }
 
@@ -70,24 +59,106 @@ int
 sys_read(void)
 {
   struct file *f;
-  int n;
+  int n, r;
   char *p;
 
-  if(argfd(0, 0, &f) < 0 || argint(2, &n) < 0 || argptr(1, &p, n) < 0)
+  if(argint(2, &n) < 0 || argptr(1, &p, n) < 0 || argfd(0, 0, &f) < 0)
     return -1;
-  return fileread(f, p, n);
+  r = fileread(f, p, n);
+  fileclose(f);
+  return r;
 }
 
 int
 sys_write(void)
 {
   struct file *f;
-  int n;
+  int n, r;
   char *p;
 
-  if(argfd(0, 0, &f) < 0 || argint(2, &n) < 0 || argptr(1, &p, n) < 0)
+  if(argint(2, &n) < 0 || argptr(1, &p, n) < 0 || argfd(0, 0, &f) < 0)
     return -1;
-  return filewrite(f, p, n);
+  r = filewrite(f, p, n);
+  fileclose(f);
+  return r;
+}
+
+// Copy the iovec array argument n of iovcnt entries into
+// kiov and check each buffer it describes.  The kernel uses
+// only the copy: the user's array may be in memory that another
+// process or thread can change under us.  The buffers may not
+// add up to more than an int's worth of bytes.
+static int
+argiov(int n, int iovcnt, struct iovec *kiov)
+{
+  struct iovec *iov;
+  uint tot;
+  int i;
+
+  if(iovcnt < 0 || iovcnt > IOV_MAX)
+    return -1;
+  if(argptr(n, (char**)&iov, iovcnt*sizeof(*iov)) < 0)
+    return -1;
+  memmove(kiov, iov, iovcnt*sizeof(*iov));
+  tot = 0;
+  for(i = 0; i < iovcnt; i++){
+    if(kiov[i].iov_len > 0x7fffffff - tot ||
+       checkptr((uint)kiov[i].iov_base, kiov[i].iov_len) < 0)
+      return -1;
+    tot += kiov[i].iov_len;
+  }
+  return 0;
+}
+
+int
+sys_readv(void)
+{
+  struct file *f;
+  struct iovec iov[IOV_MAX];
+  int n, r;
+
+  if(argint(2, &n) < 0 || argiov(1, n, iov) < 0 || argfd(0, 0, &f) < 0)
+    return -1;
+  r = filereadv(f, iov, n);
+  fileclose(f);
+  return r;
+}
+
+int
+sys_writev(void)
+{
+  struct file *f;
+  struct iovec iov[IOV_MAX];
+  int n, r;
+
+  if(argint(2, &n) < 0 || argiov(1, n, iov) < 0 || argfd(0, 0, &f) < 0)
+    return -1;
+  r = filewritev(f, iov, n);
+  fileclose(f);
+  return r;
+}
+
+// Move data between a file and a pipe without
+// copying it through user space.
+int
+sys_splice(void)
+{
+  struct file *in, *out;
+  int n, r;
+
+  if(argint(2, &n) < 0 || argfd(0, 0, &in) < 0)
+    return -1;
+  if(argfd(1, 0, &out) < 0){
+    fileclose(in);
+    return -1;
+  }
+  // No user memory is involved, and a pipe can keep us
+  // waiting.
+  vmunuse(myproc());
+  r = filesplice(in, out, n);
+  fileclose(in);
+  fileclose(out);
+  return r;
 }
 
 int
@@ -96,9 +167,8 @@ sys_close(void)
   int fd;
   struct file *f;
 
-  if(argfd(0, &fd, &f) < 0)
+  if(argint(0, &fd) < 0 || (f = fdremove(myproc()->fdt, fd)) == 0)
     return -1;
-  myproc()->ofile[fd] = 0;
   fileclose(f);
   return 0;
 }
@@ -108,20 +178,23 @@ sys_fstat(void)
 {
   struct file *f;
   struct stat *st;
+  int r;
 
-  if(argfd(0, 0, &f) < 0 || argptr(1, (void*)&st, sizeof(*st)) < 0)
+  if(argptr(1, (void*)&st, sizeof(*st)) < 0 || argfd(0, 0, &f) < 0)
     return -1;
-  return filestat(f, st);
+  r = filestat(f, st);
+  fileclose(f);
+  return r;
 }
 
 // Create the path new as a link to the same inode as old.
 int
 sys_link(void)
 {
-  char name[DIRSIZ], *new, *old;
+  char name[DIRSIZ], new[MAXPATH], old[MAXPATH];
   struct inode *dp, *ip;
 
-  if(argstr(0, &old) < 0 || argstr(1, &new) < 0)
+  if(argstr(0, old, sizeof(old)) < 0 || argstr(1, new, sizeof(new)) < 0)
     return -1;
 
   begin_op();
@@ -185,11 +258,10 @@ int
 sys_unlink(void)
 {
   struct inode *ip, *dp;
-  struct dirent de;
-  char name[DIRSIZ], *path;
+  char name[DIRSIZ], path[MAXPATH];
   uint off;
 
-  if(argstr(0, &path) < 0)
+  if(argstr(0, path, sizeof(path)) < 0)
     return -1;
 
   begin_op();
@@ -215,9 +287,7 @@ sys_unlink(void)
     goto bad;
   }
 
-  memset(&de, 0, sizeof(de));
-  if(writei(dp, (char*)&de, off, sizeof(de)) != sizeof(de))
-    panic("unlink: writei");
+  dirunlink(dp, name, off);
   if(ip->type == T_DIR){
     dp->nlink--;
     iupdate(dp);
@@ -286,12 +356,12 @@ create(char *path, short type, short major, short minor)
 int
 sys_open(void)
 {
-  char *path;
+  char path[MAXPATH];
   int fd, omode;
   struct file *f;
   struct inode *ip;
 
-  if(argstr(0, &path) < 0 || argint(1, &omode) < 0)
+  if(argstr(0, path, sizeof(path)) < 0 || argint(1, &omode) < 0)
     return -1;
 
   begin_op();
@@ -315,9 +385,7 @@ sys_open(void)
     }
   }
 
-  if((f = filealloc()) == 0 || (fd = fdalloc(f)) < 0){
-    if(f)
-      fileclose(f);
+  if((f = filealloc()) == 0){
     iunlockput(ip);
     end_op();
     return -1;
@@ -330,17 +398,23 @@ sys_open(void)
   f->off = 0;
   f->readable = !(omode & O_WRONLY);
   f->writable = (omode & O_WRONLY) || (omode & O_RDWR);
+
+  // Only now may other threads find f through fd.
+  if((fd = fdalloc(myproc()->fdt, f)) < 0){
+    fileclose(f);
+    return -1;
+  }
   return fd;
 }
 
 int
 sys_mkdir(void)
 {
-  char *path;
+  char path[MAXPATH];
   struct inode *ip;
 
   begin_op();
-  if(argstr(0, &path) < 0 || (ip = create(path, T_DIR, 0, 0)) == 0){
+  if(argstr(0, path, sizeof(path)) < 0 || (ip = create(path, T_DIR, 0, 0)) == 0){
     end_op();
     return -1;
   }
@@ -353,11 +427,11 @@ int
 sys_mknod(void)
 {
   struct inode *ip;
-  char *path;
+  char path[MAXPATH];
   int major, minor;
 
   begin_op();
-  if((argstr(0, &path)) < 0 ||
+  if((argstr(0, path, sizeof(path))) < 0 ||
      argint(1, &major) < 0 ||
      argint(2, &minor) < 0 ||
      (ip = create(path, T_DEV, major, minor)) == 0){
@@ -372,12 +446,12 @@ sys_mknod(void)
 int
 sys_chdir(void)
 {
-  char *path;
+  char path[MAXPATH];
   struct inode *ip;
   struct proc *curproc = myproc();
   
   begin_op();
-  if(argstr(0, &path) < 0 || (ip = namei(path)) == 0){
+  if(argstr(0, path, sizeof(path)) < 0 || (ip = namei(path)) == 0){
     end_op();
     return -1;
   }
@@ -388,36 +462,48 @@ sys_chdir(void)
     return -1;
   }
   iunlock(ip);
-  iput(curproc->cwd);
+  iput(fdchdir(curproc->fdt, ip));
   end_op();
-  curproc->cwd = ip;
   return 0;
 }
 
 int
 sys_exec(void)
 {
-  char *path, *argv[MAXARG];
-  int i;
+  char path[MAXPATH], *argv[MAXARG], *buf;
+  int i, n, used, r;
   uint uargv, uarg;
 
-  if(argstr(0, &path) < 0 || argint(1, (int*)&uargv) < 0){
+  if(argstr(0, path, sizeof(path)) < 0 || argint(1, (int*)&uargv) < 0){
     return -1;
   }
+  // Copy the argument strings into a page of their own; they
+  // have to fit in exec's one-page stack anyway.
+  if((buf = kalloc()) == 0)
+    return -1;
   memset(argv, 0, sizeof(argv));
+  used = 0;
   for(i=0;; i++){
     if(i >= NELEM(argv))
-      return -1;
+      goto bad;
     if(fetchint(uargv+4*i, (int*)&uarg) < 0)
-      return -1;
+      goto bad;
     if(uarg == 0){
       argv[i] = 0;
       break;
     }
-    if(fetchstr(uarg, &argv[i]) < 0)
-      return -1;
+    argv[i] = buf + used;
+    if((n = fetchstr(uarg, argv[i], PGSIZE - used)) < 0)
+      goto bad;
+    used += n + 1;
   }
-  return exec(path, argv);
+  r = exec(path, argv);
+  kfree(buf);
+  return r;
+
+ bad:
+  kfree(buf);
+  return -1;
 }
 
 int
@@ -432,9 +518,10 @@ sys_pipe(void)
   if(pipealloc(&rf, &wf) < 0)
     return -1;
   fd0 = -1;
-  if((fd0 = fdalloc(rf)) < 0 || (fd1 = fdalloc(wf)) < 0){
+  if((fd0 = fdalloc(myproc()->fdt, rf)) < 0 ||
+     (fd1 = fdalloc(myproc()->fdt, wf)) < 0){
     if(fd0 >= 0)
-      myproc()->ofile[fd0] = 0;
+      fdremove(myproc()->fdt, fd0);
     fileclose(rf);
     fileclose(wf);
     return -1;
@@ -443,3 +530,42 @@ sys_pipe(void)
   fd[1] = fd1;
   return 0;
 }
+
+int
+sys_fsstat(void)
+{
+  struct fsstat *st;
+
+  if(argptr(0, (void*)&st, sizeof(*st)) < 0)
+    return -1;
+  getfsstat(st);
+  return 0;
+}
+
+int
+sys_mmap(void)
+{
+  int addr, len, prot, flags, off;
+  struct file *f;
+
+  if(argint(0, &addr) < 0 || argint(1, &len) < 0 || argint(2, &prot) < 0 ||
+     argint(3, &flags) < 0 || argint(5, &off) < 0)
+    return -1;
+  f = 0;
+  if(!(flags & MAP_ANON) && argfd(4, 0, &f) < 0)
+    return -1;
+  addr = mmap(len, prot, flags, f, off);
+  if(f)
+    fileclose(f);
+  return addr;
+}
+
+int
+sys_munmap(void)
+{
+  int addr, len;
+
+  if(argint(0, &addr) < 0 || argint(1, &len) < 0)
+    return -1;
+  return munmap((uint)addr, len);
+}
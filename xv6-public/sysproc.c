@@ -6,6 +6,8 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "proc.h"
+#include "slabstat.h"
+#include "lockstat.h"
 
 int sys_fork(void)
 {
@@ -20,6 +22,7 @@ int sys_exit(void)
 
 int sys_wait(void)
 {
+  vmunuse(myproc());
   return wait();
 }
 
@@ -44,8 +47,7 @@ int sys_sbrk(void)
 
   if (argint(0, &n) < 0)
     return -1;
-  addr = myproc()->sz;
-  if (growproc(n) < 0)
+  if ((addr = growproc(n)) < 0)
     return -1;
   return addr;
 }
@@ -57,6 +59,7 @@ int sys_sleep(void)
 
   if (argint(0, &n) < 0)
     return -1;
+  vmunuse(myproc());
   acquire(&tickslock);
   ticks0 = ticks;
   while (ticks - ticks0 < n)
@@ -84,6 +87,47 @@ int sys_uptime(void)
   return xticks;
 }
 
+// Return the number of system calls made by the current
+// process, or with a nonzero argument, by its waited-for
+// children and their descendants.
+int sys_syscount(void)
+{
+  int children;
+
+  if (argint(0, &children) < 0)
+    return -1;
+  return children ? myproc()->cnsyscall : myproc()->nsyscall;
+}
+
+int sys_slabstat(void)
+{
+  int i;
+  struct slabstat *st;
+
+  if (argint(0, &i) < 0 || argptr(1, (void *)&st, sizeof(*st)) < 0)
+    return -1;
+  return slabstat(i, st);
+}
+
+// lockstat(i, st) copies out the statistics of lock class i;
+// lockstat(-1, 0) resets all of them.
+int sys_lockstat(void)
+{
+  int i;
+  struct lockstat *st;
+
+  if (argint(0, &i) < 0)
+    return -1;
+  if (i == -1)
+  {
+    lockstatreset();
+    return 0;
+  }
+  if (argptr(1, (void *)&st, sizeof(*st)) < 0)
+    return -1;
+  return lockstat(i, st);
+}
+
 //Added for getpinfo
 int sys_getpinfo(void)
 {
@@ -95,3 +139,77 @@ int sys_getpinfo(void)
   //return 0;
   return getpinfo(pid);
 }
+
+int sys_getpstat(void)
+{
+  int pid;
+  struct pstat *ps;
+
+  if (argint(0, &pid) < 0 || argptr(1, (void *)&ps, sizeof(*ps)) < 0)
+    return -1;
+  return getpstat(pid, ps);
+}
+
+int sys_ipiping(void)
+{
+  int cpu, n;
+
+  if (argint(0, &cpu) < 0 || argint(1, &n) < 0)
+    return -1;
+  return ipiping(cpu, n);
+}
+
+int sys_sched_setaffinity(void)
+{
+  int pid, mask;
+
+  if (argint(0, &pid) < 0 || argint(1, &mask) < 0)
+    return -1;
+  return setaffinity(pid, mask);
+}
+
+int sys_sched_getaffinity(void)
+{
+  int pid;
+
+  if (argint(0, &pid) < 0)
+    return -1;
+  return getaffinity(pid);
+}
+
+int sys_nice(void)
+{
+  int pid, n, top;
+
+  if (argint(0, &pid) < 0 || argint(1, &n) < 0 || argint(2, &top) < 0)
+    return -1;
+  return setnice(pid, n, top);
+}
+
+int sys_setsched(void)
+{
+  int pid, policy, prio;
+
+  if (argint(0, &pid) < 0 || argint(1, &policy) < 0 || argint(2, &prio) < 0)
+    return -1;
+  return setsched(pid, policy, prio);
+}
+
+int sys_clone(void)
+{
+  int fn, arg, stack;
+
+  if (argint(0, &fn) < 0 || argint(1, &arg) < 0 || argint(2, &stack) < 0)
+    return -1;
+  return clone((void (*)(void *))fn, (void *)arg, (void *)stack);
+}
+
+int sys_join(void)
+{
+  int pid;
+
+  if (argint(0, &pid) < 0)
+    return -1;
+  vmunuse(myproc());
+  return join(pid);
+}
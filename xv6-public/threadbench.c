@@ -0,0 +1,128 @@
+// Sum a 4MB array in parallel with 1, 2, 4, ... threads, up to
+// twice the number of CPUs, and report the time each takes and
+// the speedup over one thread.  The threads share the array
+// instead of copying it as fork() would.  Then check lock_t by
+// having the threads bump a shared counter.
+// Run with make CPUS=2 or more.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "x86.h"
+
+#define N        (1024*1024)
+#define PASSES   20
+#define NBUMPS   10000
+#define MAXTHREADS 16
+#define PAD      16          // ints between sums, to keep them on separate cache lines
+
+static int *a;
+static int nthreads;
+static uint sums[MAXTHREADS * PAD];
+static lock_t lock;
+static int counter;
+
+// Sum thread i's share of a, PASSES times over.
+static void
+sum(void *arg)
+{
+  int i, lo, hi, j, pass;
+  uint s;
+
+  i = (int)arg;
+  lo = N / nthreads * i;
+  hi = i == nthreads - 1 ? N : lo + N / nthreads;
+  s = 0;
+  for(pass = 0; pass < PASSES; pass++)
+    for(j = lo; j < hi; j++)
+      s += a[j];
+  sums[i * PAD] = s;
+}
+
+static void
+bump(void *arg)
+{
+  int i;
+
+  for(i = 0; i < NBUMPS; i++){
+    lock_acquire(&lock);
+    counter++;
+    lock_release(&lock);
+  }
+}
+
+// Run fn in n threads and wait for them.
+static void
+run(void (*fn)(void *), int n)
+{
+  int i;
+
+  for(i = 0; i < n; i++){
+    if(thread_create(fn, (void*)i) < 0){
+      printf(1, "threadbench: thread_create failed\n");
+      exit();
+    }
+  }
+  for(i = 0; i < n; i++){
+    if(thread_join(0) < 0){
+      printf(1, "threadbench: thread_join failed\n");
+      exit();
+    }
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, ok, max;
+  uint want, total, us, us1;
+  uint64 t0;
+
+  printf(1, "threadbench starting\n");
+  tickcycles();
+  if((a = malloc(N * sizeof(int))) == 0){
+    printf(1, "threadbench: malloc failed\n");
+    exit();
+  }
+  want = 0;
+  for(i = 0; i < N; i++){
+    a[i] = i & 0xff;
+    want += a[i];
+  }
+  want *= PASSES;
+
+  max = 2 * ncpus();
+  if(max > MAXTHREADS)
+    max = MAXTHREADS;
+  ok = 1;
+  us1 = 0;
+  for(nthreads = 1; nthreads <= max; nthreads *= 2){
+    t0 = rdtsc();
+    run(sum, nthreads);
+    us = cyclestous(rdtsc() - t0);
+    if(nthreads == 1)
+      us1 = us;
+    total = 0;
+    for(i = 0; i < nthreads; i++)
+      total += sums[i * PAD];
+    if(total != want){
+      printf(1, "threadbench: %d threads summed %d, want %d\n", nthreads, total, want);
+      ok = 0;
+    }
+    printf(1, "%d threads: %d us, speedup %d.%d%d\n", nthreads, us,
+           us1 / us, us1 * 10 / us % 10, us1 * 100 / us % 10);
+  }
+
+  lock_init(&lock);
+  run(bump, max);
+  if(counter != max * NBUMPS){
+    printf(1, "threadbench: counter %d, want %d\n", counter, max * NBUMPS);
+    ok = 0;
+  }
+
+  if(ok)
+    printf(1, "threadbench ok\n");
+  else
+    printf(1, "threadbench FAILED\n");
+  exit();
+}
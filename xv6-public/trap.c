@@ -43,6 +43,9 @@ trap(struct trapframe *tf)
     syscall();
     if(myproc()->killed)
       exit();
+    // The call may have woken a higher-priority process.
+    if(needresched())
+      yield();
     return;
   }
 
@@ -57,6 +60,14 @@ trap(struct trapframe *tf)
     }
     lapiceoi();
     break;
+  case T_IPIRESCHED:
+    // trap() checks mycpu()->resched below.
+    lapiceoi();
+    break;
+  case T_IPICALL:
+    ipipoll();
+    lapiceoi();
+    break;
   case T_IRQ0 + IRQ_IDE:
     ideintr();
     lapiceoi();
@@ -79,6 +90,12 @@ trap(struct trapframe *tf)
     lapiceoi();
     break;
 
+  case T_PGFLT:
+    // Demand-fill a page of an mmap()ed region.
+    if(myproc() && (tf->cs&3) == DPL_USER && mmapfault(rcr2()) == 0)
+      break;
+    // Not an mmap fault: fall through to kill the process.
+
   //PAGEBREAK: 13
   default:
     if(myproc() == 0 || (tf->cs&3) == 0){
@@ -101,10 +118,11 @@ trap(struct trapframe *tf)
   if(myproc() && myproc()->killed && (tf->cs&3) == DPL_USER)
     exit();
 
-  // Force process to give up CPU on clock tick.
+  // Force process to give up CPU on clock tick, or when an
+  // interrupt has woken a higher-priority process.
   // If interrupts were on while locks held, would need to check nlock.
   if(myproc() && myproc()->state == RUNNING &&
-     tf->trapno == T_IRQ0+IRQ_TIMER)
+     (tf->trapno == T_IRQ0+IRQ_TIMER || mycpu()->resched))
     yield();
 
   // Check if the process has been killed since we yielded
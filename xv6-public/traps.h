@@ -25,6 +25,8 @@
 // These are arbitrarily chosen, but with care not to overlap
 // processor defined exceptions or interrupt vectors.
 #define T_SYSCALL       64      // system call
+#define T_IPIRESCHED   240      // inter-processor: reschedule
+#define T_IPICALL      241      // inter-processor: run queued calls
 #define T_DEFAULT      500      // catchall
 
 #define T_IRQ0          32      // IRQ 0 corresponds to int T_IRQ
@@ -0,0 +1,76 @@
+// Helpers shared by the benchmarks: the TSC rate, measured
+// against the timer tick, and the number of CPUs.  Only the
+// benchmarks link this in; see the Makefile.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "x86.h"
+
+static uint ticktsc;  // TSC cycles per timer tick; 0 until measured
+
+// TSC cycles per timer tick.  The first call waits for a tick
+// boundary and times the next tick, which takes up to two ticks.
+uint
+tickcycles(void)
+{
+  uint64 t0;
+  int t;
+
+  if(ticktsc)
+    return ticktsc;
+  t = uptime();
+  while(uptime() == t)
+    ;
+  t0 = rdtsc();
+  t = uptime();
+  while(uptime() == t)
+    ;
+  ticktsc = (uint)(rdtsc() - t0);
+  return ticktsc;
+}
+
+// TSC cycles per microsecond.
+uint
+uscycles(void)
+{
+  uint n;
+
+  n = tickcycles() / TICKUS;
+  return n ? n : 1;
+}
+
+// Microseconds in c TSC cycles.  c is 64 bits because a run
+// can take longer than 2^32 cycles; the user library has no
+// 64-bit division, so divide a bit at a time.
+uint
+cyclestous(uint64 c)
+{
+  uint64 r, q;
+  uint d;
+  int i;
+
+  d = uscycles();
+  r = q = 0;
+  for(i = 63; i >= 0; i--){
+    r = r << 1 | (c >> i & 1);
+    if(r >= d){
+      r -= d;
+      q |= (uint64)1 << i;
+    }
+  }
+  return (uint)q;
+}
+
+// Number of CPUs this process may run on.
+int
+ncpus(void)
+{
+  int mask, n;
+
+  mask = sched_getaffinity(0);
+  for(n = 0; mask; mask >>= 1)
+    n += mask & 1;
+  return n;
+}
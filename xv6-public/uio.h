@@ -0,0 +1,7 @@
+// One buffer of a readv()/writev() request.
+struct iovec {
+  void *iov_base;  // start of buffer
+  uint iov_len;    // length of buffer in bytes
+};
+
+#define IOV_MAX 16  // most buffers in one readv()/writev()
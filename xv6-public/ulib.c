@@ -4,6 +4,132 @@
 #include "user.h"
 #include "x86.h"
 
+// Buffered output.  Each of the first NIOBUF file descriptors
+// has a buffer that printf() fills through fdputc().  On first
+// use a descriptor is line-buffered if it is a device such as
+// the console, unbuffered if it is 2, and fully buffered
+// otherwise.  fork, exec and exit flush every buffer first, so
+// output is neither duplicated nor lost; so does gets(), for
+// prompts written to fd 1.  close() flushes the descriptor's
+// buffer and forgets its mode, so a file opened later under
+// the same number starts afresh.
+//
+// The buffers are not locked: threads (uthread.c) that print
+// to the same descriptor at once can lose or mix output.
+
+#define NIOBUF 4
+#define IOBUFSIZ 512
+
+struct iobuf {
+  int mode;  // _IOFBF, _IOLBF or _IONBF; -1 until first use
+  int n;     // bytes in buf
+  char buf[IOBUFSIZ];
+};
+
+static struct iobuf iob[NIOBUF] = {
+  { -1 }, { -1 }, { -1 }, { -1 },
+};
+
+int _fork(void);
+int _exit(void) __attribute__((noreturn));
+int _exec(char*, char**);
+int _close(int);
+
+// Set the buffering mode of fd.
+int
+setvbuf(int fd, int mode)
+{
+  if(fd < 0 || fd >= NIOBUF || mode < _IOFBF || mode > _IONBF)
+    return -1;
+  fflush(fd);
+  iob[fd].mode = mode;
+  return 0;
+}
+
+// Write out the buffered output of fd, or of every
+// descriptor if fd is -1.
+int
+fflush(int fd)
+{
+  struct iobuf *b;
+  int r;
+
+  if(fd == -1){
+    r = 0;
+    for(fd = 0; fd < NIOBUF; fd++)
+      if(fflush(fd) < 0)
+        r = -1;
+    return r;
+  }
+  if(fd < 0 || fd >= NIOBUF)
+    return 0;
+  b = &iob[fd];
+  if(b->n == 0)
+    return 0;
+  r = write(fd, b->buf, b->n);
+  b->n = 0;
+  return r < 0 ? -1 : 0;
+}
+
+void
+fdputc(int fd, char c)
+{
+  struct iobuf *b;
+  struct stat st;
+
+  if(fd < 0 || fd >= NIOBUF){
+    write(fd, &c, 1);
+    return;
+  }
+  b = &iob[fd];
+  if(b->mode < 0){
+    if(fd == 2)
+      b->mode = _IONBF;
+    else if(fstat(fd, &st) == 0 && st.type == T_DEV)
+      b->mode = _IOLBF;
+    else
+      b->mode = _IOFBF;
+  }
+  if(b->mode == _IONBF){
+    write(fd, &c, 1);
+    return;
+  }
+  b->buf[b->n++] = c;
+  if(b->n == IOBUFSIZ || (c == '\n' && b->mode == _IOLBF))
+    fflush(fd);
+}
+
+int
+fork(void)
+{
+  fflush(-1);
+  return _fork();
+}
+
+int
+exit(void)
+{
+  fflush(-1);
+  _exit();
+}
+
+int
+exec(char *path, char **argv)
+{
+  fflush(-1);
+  return _exec(path, argv);
+}
+
+int
+close(int fd)
+{
+  if(fd >= 0 && fd < NIOBUF){
+    fflush(fd);
+    iob[fd].mode = -1;
+  }
+  return _close(fd);
+}
+
 char*
 strcpy(char *s, const char *t)
 {
@@ -55,6 +181,7 @@ gets(char *buf, int max)
   int i, cc;
   char c;
 
+  fflush(1);
   for(i=0; i+1 < max; ){
     cc = read(0, &c, 1);
     if(cc < 1)
@@ -2,9 +2,39 @@
 #include "stat.h"
 #include "user.h"
 #include "param.h"
+#include "mman.h"
 
-// Memory allocator by Kernighan and Ritchie,
-// The C programming Language, 2nd ed.  Section 8.7.
+// Requests of up to MAXSMALL bytes are rounded up to a power
+// of two and served from per-size-class free lists, so that
+// malloc and free of small objects take constant time.  Each
+// class is refilled with a run of RUNPAGES pages from sbrk(),
+// carved into equal objects.  pagemap records the class of
+// every such page, so free() finds an object's class from its
+// address without a header.
+//
+// Larger requests use the memory allocator by Kernighan and
+// Ritchie, The C programming Language, 2nd ed.  Section 8.7.
+// Requests of MMAPMIN bytes or more get their own anonymous
+// mapping, so that freeing them returns the memory to the
+// kernel instead of fragmenting the sbrk() heap.  A block in
+// use has s.ptr == 0, or MMAPPED if it is such a mapping.
+
+#define PGSIZE   4096
+#define MINSMALL 8     // smallest size class
+#define NCLASS   9     // size classes 8, 16, ..., 2048
+#define MAXSMALL (MINSMALL << (NCLASS-1))
+#define RUNPAGES 4     // pages added to a class at a time
+
+#define MMAPMIN (64*1024)
+#define MMAPPED ((Header*)1)
+
+// pagemap[va>>22][(va>>12)&1023] is 1 + the size class of the
+// page at va, or 0 if it does not hold small objects.  The
+// second-level tables are allocated from sbrk() as needed.
+static uchar *pagemap[1024];
+
+// Free objects of each class, linked through their first word.
+static char *freelist[NCLASS];
 
 typedef long Align;
 
@@ -21,12 +51,16 @@ typedef union header Header;
 static Header base;
 static Header *freep;
 
-void
-free(void *ap)
+static void
+largefree(void *ap)
 {
   Header *bp, *p;
 
   bp = (Header*)ap - 1;
+  if(bp->s.ptr == MMAPPED){
+    munmap(bp, bp->s.size * sizeof(Header));
+    return;
+  }
   for(p = freep; !(bp > p && bp < p->s.ptr); p = p->s.ptr)
     if(p >= p->s.ptr && (bp > p || bp < p->s.ptr))
       break;
@@ -56,17 +90,27 @@ morecore(uint nu)
     return 0;
   hp = (Header*)p;
   hp->s.size = nu;
-  free((void*)(hp + 1));
+  hp->s.ptr = 0;
+  largefree((void*)(hp + 1));
   return freep;
 }
 
-void*
-malloc(uint nbytes)
+static void*
+largealloc(uint nbytes)
 {
   Header *p, *prevp;
   uint nunits;
 
   nunits = (nbytes + sizeof(Header) - 1)/sizeof(Header) + 1;
+  if(nbytes >= MMAPMIN){
+    p = mmap(0, nunits * sizeof(Header), PROT_READ|PROT_WRITE,
+             MAP_PRIVATE|MAP_ANON, -1, 0);
+    if(p == MAP_FAILED)
+      return 0;
+    p->s.size = nunits;
+    p->s.ptr = MMAPPED;
+    return (void*)(p + 1);
+  }
   if((prevp = freep) == 0){
     base.s.ptr = freep = prevp = &base;
     base.s.size = 0;
@@ -80,6 +124,7 @@ malloc(uint nbytes)
         p += p->s.size;
         p->s.size = nunits;
       }
+      p->s.ptr = 0;
       freep = prevp;
       return (void*)(p + 1);
     }
@@ -88,3 +133,86 @@ malloc(uint nbytes)
         return 0;
   }
 }
+
+// Return the size class for an n-byte request.
+static int
+sizeclass(uint n)
+{
+  int c;
+
+  for(c = 0; (MINSMALL << c) < n; c++)
+    ;
+  return c;
+}
+
+// Add a run of pages, carved into objects, to class c.
+static int
+refill(int c)
+{
+  char *p, *a, *end, *obj;
+  uchar **l1;
+  uint va;
+
+  // Make sure the pagemap covers the run, then take the run
+  // from the next page boundary.
+  for(;;){
+    p = sbrk(0);
+    a = (char*)(((uint)p + PGSIZE-1) & ~(PGSIZE-1));
+    end = a + RUNPAGES*PGSIZE;
+    for(va = (uint)a; va < (uint)end; va += PGSIZE)
+      if(pagemap[va >> 22] == 0)
+        break;
+    if(va == (uint)end)
+      break;
+    l1 = &pagemap[va >> 22];
+    if((*l1 = (uchar*)sbrk(1024)) == (uchar*)-1){
+      *l1 = 0;
+      return -1;
+    }
+    memset(*l1, 0, 1024);
+  }
+  if((uint)end < (uint)a || sbrk(end - p) != p)
+    return -1;
+
+  for(va = (uint)a; va < (uint)end; va += PGSIZE)
+    pagemap[va >> 22][(va >> 12) & 1023] = c + 1;
+  for(obj = end - (MINSMALL << c); obj >= a; obj -= MINSMALL << c){
+    *(char**)obj = freelist[c];
+    freelist[c] = obj;
+  }
+  return 0;
+}
+
+void
+free(void *ap)
+{
+  uchar *l2;
+  uint va;
+  int c;
+
+  if(ap == 0)
+    return;
+  va = (uint)ap;
+  if((l2 = pagemap[va >> 22]) != 0 && (c = l2[(va >> 12) & 1023]) != 0){
+    *(char**)ap = freelist[c-1];
+    freelist[c-1] = ap;
+    return;
+  }
+  largefree(ap);
+}
+
+void*
+malloc(uint nbytes)
+{
+  char *p;
+  int c;
+
+  if(nbytes > MAXSMALL)
+    return largealloc(nbytes);
+  c = sizeclass(nbytes);
+  if(freelist[c] == 0 && refill(c) < 0)
+    return 0;
+  p = freelist[c];
+  freelist[c] = *(char**)p;
+  return p;
+}
@@ -1,5 +1,10 @@
 struct stat;
 struct rtcdate;
+struct fsstat;
+struct iovec;
+struct slabstat;
+struct lockstat;
+struct pstat;
 
 // system calls
 int fork(void);
@@ -24,6 +29,23 @@ char *sbrk(int);
 int sleep(int);
 int uptime(void);
 int getpinfo(int);
+int fsstat(struct fsstat *);
+void *mmap(void *, int, int, int, int, int);
+int munmap(void *, int);
+int splice(int, int, int);
+int readv(int, struct iovec *, int);
+int writev(int, struct iovec *, int);
+int syscount(int);
+int slabstat(int, struct slabstat *);
+int lockstat(int, struct lockstat *);
+int getpstat(int, struct pstat *);
+int ipiping(int, int);
+int sched_setaffinity(int, uint);
+int sched_getaffinity(int);
+int nice(int, int, int);
+int setsched(int, int, int);
+int clone(void (*)(void *), void *, void *);
+int join(int);
 
 // ulib.c
 int stat(const char *, struct stat *);
@@ -38,3 +60,29 @@ void *memset(void *, int, uint);
 void *malloc(uint);
 void free(void *);
 int atoi(const char *);
+int setvbuf(int, int);
+int fflush(int);
+void fdputc(int, char);
+
+// uthread.c
+typedef struct {
+  volatile uint locked;
+} lock_t;
+void lock_init(lock_t *);
+void lock_acquire(lock_t *);
+void lock_release(lock_t *);
+int thread_create(void (*)(void *), void *);
+int thread_join(int);
+void *thread_malloc(uint);
+void thread_free(void *);
+
+// ubench.c
+uint tickcycles(void);
+uint uscycles(void);
+uint cyclestous(uint64);
+int ncpus(void);
+
+// setvbuf() modes
+#define _IOFBF 0  // write when the buffer fills
+#define _IOLBF 1  // also write at each newline
+#define _IONBF 2  // write each byte at once
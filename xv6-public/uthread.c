@@ -0,0 +1,140 @@
+// User-level threads, on top of clone() and join().
+//
+// Each thread runs on a TSTACK-byte stack from thread_malloc().
+// The function and argument it starts with sit at the top of
+// that stack, above where the thread's stack pointer starts,
+// so creating a thread needs nothing else.
+//
+// malloc() and free() are not thread-safe, and taking a lock
+// in them would slow down every program for the sake of a few.
+// Threads allocate with thread_malloc() and thread_free()
+// instead, which hold heaplock.  printf()'s buffers (ulib.c)
+// are not locked either; threads should not print to the same
+// descriptor at once.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "x86.h"
+
+#define TSTACK 8192
+
+struct start {
+  void (*fn)(void *);
+  void *arg;
+};
+
+// Stacks of the threads not yet joined, to free at join.
+static struct {
+  int tid;          // 0 if unused, -1 while being created
+  char *stack;
+} threads[NPROC];
+static lock_t tlock;
+static lock_t heaplock;
+
+void
+lock_init(lock_t *l)
+{
+  l->locked = 0;
+}
+
+void
+lock_acquire(lock_t *l)
+{
+  while(xchg(&l->locked, 1) != 0)
+    while(l->locked)
+      cpu_relax();
+}
+
+void
+lock_release(lock_t *l)
+{
+  xchg(&l->locked, 0);
+}
+
+void*
+thread_malloc(uint n)
+{
+  void *p;
+
+  lock_acquire(&heaplock);
+  p = malloc(n);
+  lock_release(&heaplock);
+  return p;
+}
+
+void
+thread_free(void *p)
+{
+  lock_acquire(&heaplock);
+  free(p);
+  lock_release(&heaplock);
+}
+
+static void
+thread_start(void *arg)
+{
+  struct start *s = arg;
+
+  s->fn(s->arg);
+  exit();
+}
+
+// Start a thread running fn(arg), sharing this process's
+// memory.  Returns its thread id, or -1.
+int
+thread_create(void (*fn)(void *), void *arg)
+{
+  struct start *s;
+  char *stack;
+  int i, tid;
+
+  if((stack = thread_malloc(TSTACK)) == 0)
+    return -1;
+  s = (struct start*)(stack + TSTACK) - 1;
+  s->fn = fn;
+  s->arg = arg;
+
+  lock_acquire(&tlock);
+  for(i = 0; i < NPROC && threads[i].tid != 0; i++)
+    ;
+  if(i < NPROC)
+    threads[i].tid = -1;
+  lock_release(&tlock);
+  if(i == NPROC){
+    thread_free(stack);
+    return -1;
+  }
+
+  if((tid = clone(thread_start, s, s)) < 0){
+    threads[i].tid = 0;
+    thread_free(stack);
+    return -1;
+  }
+  threads[i].stack = stack;
+  threads[i].tid = tid;
+  return tid;
+}
+
+// Wait for thread tid, or any thread if tid is 0, to finish,
+// and free its stack.  Any thread may join any other, not
+// only the one that created it.  Returns its thread id, or -1.
+int
+thread_join(int tid)
+{
+  int i;
+
+  if((tid = join(tid)) < 0)
+    return -1;
+  lock_acquire(&tlock);
+  for(i = 0; i < NPROC; i++){
+    if(threads[i].tid == tid){
+      thread_free(threads[i].stack);
+      threads[i].tid = 0;
+      break;
+    }
+  }
+  lock_release(&tlock);
+  return tid;
+}
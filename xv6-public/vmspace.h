@@ -0,0 +1,31 @@
+// A memory mapping created by mmap() (see mmap.c).
+struct vma
+{
+  uint start;     // page-aligned first address
+  uint end;       // first address past the mapping; 0 if slot unused
+  int prot;       // PROT_READ, PROT_WRITE
+  int flags;      // MAP_SHARED, MAP_PRIVATE, MAP_ANON
+  struct file *f; // mapped file, or 0 for MAP_ANON
+  uint off;       // file offset of start
+};
+
+// A process's address space: its page table and what is
+// mapped in it.  The threads clone() makes share one.
+//
+// A thread in a system call holds its address space for use
+// (vmuse() in proc.c), so that the user memory the call
+// touches stays mapped; a thread that removes memory (munmap,
+// sbrk with a negative size) first waits for the others to let
+// go (vmshrink()).  Changes of any kind hold mlock.
+struct vmspace
+{
+  int ref;                // processes using it, zombies included
+  int live;               // of those, ones that have not exited
+  struct spinlock lock;   // protects users and shrinking
+  int users;              // threads holding it for use
+  int shrinking;          // a thread waits to remove memory
+  struct sleeplock mlock; // held while changing what follows
+  pde_t *pgdir;           // Page table
+  uint sz;                // Size of process memory (bytes)
+  struct vma vmas[NVMA];  // Memory mappings (mmap.c)
+};
@@ -0,0 +1,104 @@
+// Measure how quickly a woken process gets the CPU while CPU
+// hogs run in q2.  sleep(1) is woken from the timer interrupt,
+// the same way a keypress wakes the shell from the keyboard
+// interrupt; the pipe ping-pong is woken from system calls.
+// With wakeup preemption neither should wait for a hog's
+// 8-tick slice to end.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "x86.h"
+
+#define NHOGS    2
+#define NSLEEPS  100
+#define NPINGS   1000
+
+static void
+stats(char *what, uint *us, int n)
+{
+  uint tot, max;
+  int i;
+
+  if(n == 0)
+    return;
+  tot = max = 0;
+  for(i = 0; i < n; i++){
+    tot += us[i];
+    if(us[i] > max)
+      max = us[i];
+  }
+  printf(1, "  %s: avg %d us, max %d us\n", what, tot / n, max);
+}
+
+static uint us[NPINGS];
+
+static void
+measure(void)
+{
+  int fds[2], back[2], pid, i;
+  uint64 t0;
+  char c;
+
+  for(i = 0; i < NSLEEPS; i++){
+    t0 = rdtsc();
+    sleep(1);
+    us[i] = cyclestous(rdtsc() - t0);
+  }
+  stats("sleep(1)", us, NSLEEPS);
+
+  if(pipe(fds) < 0 || pipe(back) < 0){
+    printf(1, "wakebench: pipe failed\n");
+    exit();
+  }
+  if((pid = fork()) == 0){
+    close(fds[1]);
+    close(back[0]);
+    while(read(fds[0], &c, 1) == 1)
+      write(back[1], &c, 1);
+    exit();
+  }
+  close(fds[0]);
+  close(back[1]);
+  for(i = 0; i < NPINGS; i++){
+    t0 = rdtsc();
+    if(write(fds[1], "x", 1) != 1 || read(back[0], &c, 1) != 1){
+      printf(1, "wakebench: ping-pong failed\n");
+      break;
+    }
+    us[i] = cyclestous(rdtsc() - t0);
+  }
+  close(fds[1]);
+  close(back[0]);
+  wait();
+  stats("pipe round trip", us, i);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int pids[NHOGS], i;
+
+  printf(1, "wakebench starting\n");
+  tickcycles();
+
+  printf(1, "idle:\n");
+  measure();
+
+  for(i = 0; i < NHOGS; i++){
+    if((pids[i] = fork()) == 0)
+      for(;;)
+        ;
+  }
+  // Give the hogs time to use up their q0 and q1 allotments.
+  sleep(10);
+  printf(1, "with %d hogs in q2:\n", NHOGS);
+  measure();
+
+  for(i = 0; i < NHOGS; i++){
+    kill(pids[i]);
+    wait();
+  }
+  printf(1, "wakebench ok\n");
+  exit();
+}
@@ -1,30 +1,54 @@
 #include "types.h"
 #include "stat.h"
 #include "user.h"
+#include "mman.h"
 
 char buf[512];
+int l, w, c, inword;
+int usemmap;  // -m: map the file instead of reading it
+
+void
+count(char *p, int n)
+{
+  int i;
+
+  for(i=0; i<n; i++){
+    c++;
+    if(p[i] == '\n')
+      l++;
+    if(strchr(" \r\t\n\v", p[i]))
+      inword = 0;
+    else if(!inword){
+      w++;
+      inword = 1;
+    }
+  }
+}
 
 void
 wc(int fd, char *name)
 {
-  int i, n;
-  int l, w, c, inword;
+  int n;
+  struct stat st;
+  char *p;
 
   l = w = c = 0;
   inword = 0;
-  while((n = read(fd, buf, sizeof(buf))) > 0){
-    for(i=0; i<n; i++){
-      c++;
-      if(buf[i] == '\n')
-        l++;
-      if(strchr(" \r\t\n\v", buf[i]))
-        inword = 0;
-      else if(!inword){
-        w++;
-        inword = 1;
+  if(usemmap && fstat(fd, &st) == 0 && st.type == T_FILE){
+    if(st.size > 0){
+      p = mmap(0, st.size, PROT_READ, MAP_SHARED, fd, 0);
+      if(p == MAP_FAILED){
+        printf(1, "wc: mmap error\n");
+        exit();
       }
+      count(p, st.size);
+      munmap(p, st.size);
     }
+    printf(1, "%d %d %d %s\n", l, w, c, name);
+    return;
   }
+  while((n = read(fd, buf, sizeof(buf))) > 0)
+    count(buf, n);
   if(n < 0){
     printf(1, "wc: read error\n");
     exit();
@@ -37,12 +61,17 @@ main(int argc, char *argv[])
 {
   int fd, i;
 
-  if(argc <= 1){
+  i = 1;
+  if(argc > 1 && strcmp(argv[1], "-m") == 0){
+    usemmap = 1;
+    i++;
+  }
+  if(i >= argc){
     wc(0, "");
     exit();
   }
 
-  for(i = 1; i < argc; i++){
+  for(; i < argc; i++){
     if((fd = open(argv[i], 0)) < 0){
       printf(1, "wc: cannot open %s\n", argv[i]);
       exit();
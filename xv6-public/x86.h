@@ -130,6 +130,22 @@ xchg(volatile uint *addr, uint newval)
   return result;
 }
 
+// Read the CPU's time-stamp counter.
+static inline uint64
+rdtsc(void)
+{
+  uint lo, hi;
+
+  asm volatile("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64)hi << 32) | lo;
+}
+
+static inline void
+cpu_relax(void)
+{
+  asm volatile("pause");
+}
+
 static inline uint
 rcr2(void)
 {
@@ -144,6 +160,14 @@ lcr3(uint val)
   asm volatile("movl %0,%%cr3" : : "r" (val));
 }
 
+static inline uint
+rcr3(void)
+{
+  uint val;
+  asm volatile("movl %%cr3,%0" : "=r" (val));
+  return val;
+}
+
 //PAGEBREAK: 36
 // Layout of the trap frame built on the stack by the
 // hardware and by trapasm.S, and passed to trap().